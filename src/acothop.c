@@ -58,6 +58,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#include <signal.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "ants.h"
 #include "utilities.h"
@@ -66,15 +70,52 @@
 #include "timer.h"
 #include "ls.h"
 
+static volatile sig_atomic_t stop_signal = 0;  /* set by SIGTERM or SIGINT */
+
+static void catch_signal( int sig )
+/*    
+      FUNCTION:       note that the run has to stop
+      INPUT:          number of the signal
+      OUTPUT:         none
+      (SIDE)EFFECTS:  stop_signal is set; the current try ends after the current 
+                      iteration and the best solution is saved, as well as a final 
+                      checkpoint if --checkpoint or --resume is given
+ */
+{
+    stop_signal = sig;
+}
+
+static long int budget_exhausted( void )
+/*    
+      FUNCTION:       checks whether the budget of a try is used up
+      INPUT:          none
+      OUTPUT:         TRUE if max_evaluations packing plans have been evaluated 
+                      or, without an evaluation limit, if max_time is reached
+      (SIDE)EFFECTS:  none
+ */
+{
+    long int evaluations;
+
+    if ( max_evaluations <= 0 )
+        return deadline_reached();
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    evaluations = n_evaluations;
+    return ( evaluations >= max_evaluations );
+}
+
 long int termination_condition( void )
 /*    
       FUNCTION:       checks whether termination condition is met 
       INPUT:          none
       OUTPUT:         0 if condition is not met, number neq 0 otherwise
       (SIDE)EFFECTS:  none
+      COMMENTS:       an evaluation limit replaces the limits on tours and time, 
+                      so that runs do the same work on every machine
  */
 {
-    return ( ((n_tours >= max_tours) && (elapsed_time( VIRTUAL ) >= max_time)) ||
+    return ( stop_signal || ((max_evaluations > 0 || n_tours >= max_tours) && budget_exhausted()) ||
             (best_so_far_ant->fitness <= optimal));
 }
 
@@ -86,8 +127,10 @@ void construct_solutions( void )
       (SIDE)EFFECTS:  when finished, all ants of the colony have constructed a solution  
  */
 {
-    long int k;        /* counter variable */
+    long int k, i;     /* counter variables */
     long int step;    /* counter of the number of construction steps */
+    long int n_steps; /* number of construction steps made by the ants */
+    long int n_active; /* number of ants that are still constructing */
     
     TRACE ( printf("construct solutions for all ants\n"); );
 
@@ -104,65 +147,214 @@ void construct_solutions( void )
         ant[k].visited[instance.n - 2] = TRUE;
         ant[k].tour[instance.n - 1] = instance.n - 1;
         ant[k].visited[instance.n - 1] = TRUE;
+        ant[k].n_constructed = 0;
+        ant[k].time_max_speed = 0.;
+    }
+
+    n_steps = instance.n - 3;
+    if ( reduce_flag ) {
+        /* pruned cities cannot be visited within max_time; they are not 
+           chosen by the ants but appended to the tours after construction */
+        for ( k = 0 ; k < n_ants ; k++ ) {
+            for ( i = 0 ; i < instance.n_pruned ; i++ ) {
+                ant[k].visited[instance.pruned_cities[i]] = TRUE;
+            }
+        }
+        n_steps -= instance.n_pruned;
     }
 
+    if ( acs_flag && acs_deferred_flag )
+        refresh_pheromone_rows();  /* so that the steps only read pheromone and total */
+
+    n_active = n_ants;
     step = 0;
-    while ( step < instance.n - 3 ) {
+    while ( step < n_steps && n_active > 0 ) {
         step++;
         for ( k = 0 ; k < n_ants ; k++ ) {
+            if ( ant[k].n_constructed < step - 1 )
+                continue;  /* ant k already stopped its construction */
             neighbour_choose_and_move_to_next( &ant[k], step);
-            if ( acs_flag )
+            if ( partial_flag && !time_bounded_move( &ant[k], step ) ) {
+                n_active--;
+                continue;
+            }
+            ant[k].n_constructed = step;
+            if ( acs_flag && !acs_deferred_flag )
                 local_acs_pheromone_update( &ant[k], step );
         }
+        if ( acs_flag && acs_deferred_flag )
+            deferred_local_acs_pheromone_update( step );
+    }
+
+    for ( k = 0 ; k < n_ants ; k++ ) {
+        complete_tour( &ant[k] );
     }
 
     step = instance.n;
     for ( k = 0 ; k < n_ants ; k++ ) {
         ant[k].tour[instance.n] = ant[k].tour[0];
-        ant[k].fitness = compute_fitness( ant[k].tour, ant[k].packing_plan );
-        if ( acs_flag )
+        ant[k].fitness = compute_fitness( ant[k].tour, ant[k].packing_plan, ant[k].n_constructed );
+        if ( acs_flag && !acs_deferred_flag )
             local_acs_pheromone_update( &ant[k], step );
     }
+    if ( acs_flag && acs_deferred_flag )
+        deferred_local_acs_pheromone_update( step );
     n_tours += n_ants;
 }
 
+static long int local_search_ant( long int k, ls_context *ctx, long int stream )
+/*    
+      FUNCTION:       apply local search to ant k
+      INPUT:          index of the ant, scratch space of the local search and seed 
+                      of the random number stream of the ant
+      OUTPUT:         decrease of the fitness of ant k
+      (SIDE)EFFECTS:  ant k holds the locally optimal tour, or its constructed tour 
+                      if the fitness of the locally optimal one is worse
+      COMMENTS:       2-opt, 2.5-opt and 3-opt optimize the length of the active prefix 
+                      of the tour (see prefix_local_search), which does not imply a 
+                      better ThOP fitness; hence the revert. The ThOP local search never 
+                      worsens the fitness. Only ant k, prev_ls_ant[k] and ctx are 
+                      written, so different ants may be searched in parallel. The random 
+                      numbers are drawn from the stream of the ant, not of the worker, 
+                      so the result does not depend on which worker searches the ant
+ */
+{
+    long int fitness = ant[k].fitness;
+
+    ctx->rng = &stream;
+    if ( ls_flag == 4 ) {
+        thop_local_search( &ant[k], ctx );  /* ThOP local search */
+    }
+    else {
+        copy_from_to( &ant[k], &prev_ls_ant[k] );
+        prefix_local_search( &ant[k], ctx );
+        ant[k].fitness = compute_fitness_rng( ant[k].tour, ant[k].packing_plan, ant[k].n_constructed, ctx->rng );
+        if ( ant[k].fitness > prev_ls_ant[k].fitness )
+            copy_from_to( &prev_ls_ant[k], &ant[k] );
+    }
+    ctx->rng = &seed;
+    return fitness - ant[k].fitness;
+}
+
+static long int select_ls_ants( long int *selected )
+/*    
+      FUNCTION:       choose the ants to which local search is applied, see ls_policy
+      INPUT:          array of length n_ants
+      OUTPUT:         number of chosen ants
+      (SIDE)EFFECTS:  selected holds the indices of the chosen ants; for all policies 
+                      but LS_ALL in order of increasing fitness before local search
+      COMMENTS:       LS_RANK chooses the ant of rank r (0 is the best) with probability 
+                      ls_ants * (n_ants - r) / (n_ants * (n_ants + 1) / 2), capped at 1, 
+                      so that about ls_ants ants are chosen, preferably good ones. 
+                      LS_BUDGET chooses all ants; local_search stops once the budget 
+                      is spent
+ */
+{
+    long int k, r, n_selected = 0;
+    sort_pair_long pairs[MAX_ANTS];
+
+    if ( ls_policy == LS_ALL ) {
+        for ( k = 0 ; k < n_ants ; k++ )
+            selected[k] = k;
+        return n_ants;
+    }
+    for ( k = 0 ; k < n_ants ; k++ ) {
+        pairs[k].key = ant[k].fitness;
+        pairs[k].index = k;
+    }
+    sort_pairs_long( pairs, n_ants );
+    for ( r = 0 ; r < n_ants ; r++ ) {
+        if ( ls_policy == LS_TOP_K && r >= ls_ants )
+            break;
+        if ( ls_policy == LS_RANK && ran01( &seed ) >= 
+             (double) ls_ants * (double) (n_ants - r) / ( 0.5 * (double) n_ants * (double) (n_ants + 1) ) )
+            continue;
+        selected[n_selected++] = pairs[r].index;
+    }
+    return n_selected;
+}
+
 void local_search( void )
 /*    
-      FUNCTION:       manage the local search phase; apply local search to ALL ants; in 
-                      dependence of ls_flag one of 2-opt, 2.5-opt, and 3-opt local search
-                      is chosen.
+      FUNCTION:       manage the local search phase; apply local search to the ants 
+                      chosen by ls_policy; in dependence of ls_flag one of 2-opt, 
+                      2.5-opt, 3-opt and the ThOP local search is chosen.
       INPUT:          none
       OUTPUT:         none
-      (SIDE)EFFECTS:  all ants of the colony have locally optimal tours
+      (SIDE)EFFECTS:  the chosen ants have locally optimal tours; ls_calls, ls_improved, 
+                      ls_gain and ls_time are updated
       COMMENTS:       typically, best performance is obtained by applying local search 
                       to all ants. It is known that some improvements (e.g. convergence 
                       speed towards high quality solutions) may be obtained for some 
                       ACO algorithms by applying local search to only some of the ants.
                       Overall best performance is typcially obtained by using 3-opt.
+                      If compiled with OpenMP, the ants are distributed over the threads, 
+                      each with its own context in ls_workspaces. The run can only end 
+                      during local search by reaching max_time, and only once max_tours 
+                      is reached; then worker 0 checks the clock after each of its ants 
+                      and raises a shared stop flag, and no worker starts another ant. 
+                      The budget of LS_BUDGET is checked in the same way; it and ls_time 
+                      are measured in wall-clock time, since the CPU time of the process 
+                      adds up the time of all threads. With dlb_flag 
+                      2, the best-so-far tour is the reference tour of the local search. 
+                      The seeds of the random number streams of the chosen ants are 
+                      drawn from seed before the ants are distributed, so a seeded run 
+                      gives the same result for any number of threads and any schedule, 
+                      unless it is stopped by the clock during local search
  */
 {
-    long int k;
-
-    TRACE ( printf("apply local search to all ants\n"); );
-
-    for ( k = 0 ; k < n_ants ; k++ ) {
-        switch (ls_flag) {
-        case 1:
-            two_opt_first( ant[k].tour, instance.n );    /* 2-opt local search */
-            break;
-        case 2:
-            two_h_opt_first( ant[k].tour, instance.n );  /* 2.5-opt local search */
-            break;
-        case 3:
-            three_opt_first( ant[k].tour, instance.n );  /* 3-opt local search */
-            break;
-        default:
-            fprintf(stderr,"type of local search procedure not correctly specified\n");
-            exit(1);
+    long int i, w = 0;
+    long int deadline;   /* TRUE if the run ends once its time or evaluation budget is used up */
+    long int stop;       /* set once the termination condition holds */
+    long int stopped;
+    long int selected[MAX_ANTS], n_selected;
+    long int stream[MAX_ANTS];  /* seeds of the random number streams of the chosen ants */
+    long int gain, calls = 0, improved = 0, sum_gain = 0;
+    double   start;
+
+    TRACE ( printf("apply local search to the chosen ants\n"); );
+
+    start = elapsed_time( REAL );
+    deadline = ( max_evaluations > 0 || n_tours >= max_tours );
+    stop = ( best_so_far_ant->fitness <= optimal );
+    n_selected = select_ls_ants( selected );
+    for ( i = 0 ; i < n_selected ; i++ )
+        stream[i] = 1 + (long int) ( ran01( &seed ) * 2147483646.0 );
+    if ( dlb_flag == 2 && best_so_far_ant->fitness < INFTY )
+        set_ls_reference( best_so_far_ant->tour );
+
+#ifdef _OPENMP
+#pragma omp parallel for private(w, stopped, gain) reduction(+:calls, improved, sum_gain) schedule(dynamic)
+#endif
+    for ( i = 0 ; i < n_selected ; i++ ) {
+#ifdef _OPENMP
+        w = omp_get_thread_num();
+#pragma omp atomic read
+#endif
+        stopped = stop;
+        if ( stopped )
+            continue;
+        gain = local_search_ant( selected[i], ls_workspaces[w], stream[i] );
+        calls++;
+        if ( gain > 0 ) {
+            improved++;
+            sum_gain += gain;
+        }
+        if ( w == 0 && ( deadline || ls_policy == LS_BUDGET || stop_signal ) ) {
+            if ( stop_signal || ( deadline && budget_exhausted() ) || 
+                 ( ls_policy == LS_BUDGET && elapsed_time( REAL ) - start >= ls_budget ) ) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+                stop = TRUE;
+            }
         }
-        ant[k].fitness = compute_fitness( ant[k].tour, ant[k].packing_plan );
-        if (termination_condition()) return;
     }
+    set_ls_reference( NULL );
+    ls_calls += calls;
+    ls_improved += improved;
+    ls_gain += sum_gain;
+    ls_time += elapsed_time( REAL ) - start;
 }
 
 void update_statistics( void )
@@ -184,10 +376,11 @@ void update_statistics( void )
 
     if ( ant[iteration_best_ant].fitness < best_so_far_ant->fitness ) {
         
-        time_used = elapsed_time( VIRTUAL ); /* best sol found after time_used */
+        time_used = elapsed_time( budget_timer ); /* best sol found after time_used */
         copy_from_to( &ant[iteration_best_ant], best_so_far_ant );
 
         found_best = iteration;
+        found_evaluations = n_evaluations;
         restart_found_best = iteration;
         found_branching = node_branching(lambda);
         branching_factor = found_branching;
@@ -227,9 +420,9 @@ void search_control_and_statistics( void )
 
     if (!(iteration % 100)) {
         population_statistics();
-        branching_factor = node_branching(lambda);
         /*printf("\nbest so far %ld, iteration: %ld, time %.2f, b_fac %.5f\n",best_so_far_ant->fitness,iteration,elapsed_time( VIRTUAL),branching_factor);*/
-        if ( mmas_flag && (branching_factor < branch_fac) && (iteration - restart_found_best > 250) ) {
+        if ( mmas_flag && (branching_factor < branch_fac || distance_ants < restart_distance * instance.n) 
+             && (iteration - restart_found_best > 250) ) {
             /* MAX-MIN Ant System was the first ACO algorithm to use
                pheromone trail re-initialisation as implemented
                here. Other ACO algorithms may also profit from this mechanism.
@@ -238,7 +431,7 @@ void search_control_and_statistics( void )
             init_pheromone_trails( trail_max );
             compute_total_information();
             restart_iteration = iteration;
-            restart_time = elapsed_time( VIRTUAL );
+            restart_time = elapsed_time( budget_timer );
         }
         /*printf("try %li, iteration %li, b-fac %f \n\n", n_try,iteration,branching_factor);*/
     }
@@ -380,7 +573,7 @@ void bwas_update( void )
         restart_best_ant->fitness = INFTY;
         init_pheromone_trails( trail_0 );
         restart_iteration = iteration;
-        restart_time = elapsed_time( VIRTUAL );
+        restart_time = elapsed_time( budget_timer );
         /*printf("init pheromone trails with %.15f, iteration %ld\n",trail_0,iteration);*/
     }
     else
@@ -404,6 +597,22 @@ void acs_global_update( void )
     global_acs_pheromone_update( best_so_far_ant );
 }
 
+void paco_update( void )
+/*    
+      FUNCTION:       manage the pheromone update of population-based ACO
+      INPUT:          none
+      OUTPUT:         none
+      (SIDE)EFFECTS:  the iteration-best ant enters the population and the oldest 
+                      solution leaves it
+      COMMENTS:       there is no evaporation; the update touches only the arcs of 
+                      two solutions and updates total for them
+ */
+{
+    TRACE ( printf("Population-based ACO pheromone update\n"); );
+
+    paco_population_update( &ant[find_best()] );
+}
+
 void pheromone_trail_update( void )  
 /*    
       FUNCTION:       manage global pheromone trail update for the ACO algorithms
@@ -413,6 +622,26 @@ void pheromone_trail_update( void )
                       according to the rules defined by the various ACO algorithms.
  */
 {
+    if ( mmas_flag && !ls_flag ) {
+        /* MMAS without local search updates only the arcs above trail_min, see 
+           build_active_arcs; if trail_min changed or the trails were 
+           re-initialised, all arcs are updated in one sweep over the matrices 
+           and the list is rebuilt */
+        if ( active_arcs_valid && active_trail_min == trail_min ) {
+            mmas_evaporation_active_arcs();
+            mmas_update();
+            mmas_update_active_arcs();
+        } else {
+            active_arcs_valid = FALSE;
+            fused_update = TRUE;
+            mmas_update();
+            fused_update = FALSE;
+            mmas_fused_pheromone_update();
+            build_active_arcs();
+        }
+        return;
+    }
+
     /* Simulate the pheromone evaporation of all pheromones; this is not necessary
        for ACS (see also ACO Book) */
     if ( as_flag || eas_flag || ras_flag || bwas_flag || mmas_flag ) {
@@ -444,6 +673,8 @@ void pheromone_trail_update( void )
         bwas_update();
     else if ( acs_flag )
         acs_global_update();
+    else if ( paco_flag )
+        paco_update();
 
     /* check pheromone trail limits for MMAS; not necessary if local
      search is used, because in the local search case lower pheromone trail
@@ -452,8 +683,8 @@ void pheromone_trail_update( void )
         check_pheromone_trail_limits();
 
     /* Compute combined information pheromone times heuristic info after
-     the pheromone update for all ACO algorithms except ACS; in the ACS case 
-     this is already done in the pheromone update procedures of ACS */
+     the pheromone update for all ACO algorithms except ACS and PACO; in these 
+     cases this is already done in their pheromone update procedures */
     if ( as_flag || eas_flag || ras_flag || mmas_flag || bwas_flag ) {
         if ( ls_flag ) {
             compute_nn_list_total_information();
@@ -474,7 +705,8 @@ int main(int argc, char *argv[]) {
       COMMENTS:       this function controls the run of "max_tries" independent trials
      */
 
-    long int i, k;
+    long int i, first_try;
+    double   checkpoint_at;  /* wall-clock time of the next checkpoint */
 
     start_timers();
 
@@ -483,31 +715,41 @@ int main(int argc, char *argv[]) {
     instance.nn_list = compute_nn_lists();
     pheromone = generate_double_matrix( instance.n, instance.n );
     total = generate_double_matrix( instance.n, instance.n );
+    heuristic = generate_double_matrix( instance.n, instance.n );
+    compute_heuristic_information();
+    row_epoch = calloc(instance.n, sizeof(long int));
+    if ( ls_flag ) {
+#ifdef _OPENMP
+        allocate_ls_workspaces( omp_get_max_threads() );
+#else
+        allocate_ls_workspaces( 1 );
+#endif
+    }
+    if ( mmas_flag && !ls_flag )
+        allocate_arc_states();
 
-    time_used = elapsed_time( VIRTUAL );
+    time_used = elapsed_time( budget_timer );
     /*printf("Initialization took %.10f seconds\n",time_used);*/
     
     long int* prev_fitness = malloc(n_ants * sizeof(long int));
     
-    for ( n_try = 0 ; n_try < max_tries ; n_try++ ) {
+    signal( SIGTERM, catch_signal );
+    signal( SIGINT, catch_signal );
+    first_try = resume_flag ? checkpoint_try() : -1;
+    
+    for ( n_try = MAX(first_try, 0) ; n_try < max_tries && !stop_signal ; n_try++ ) {
 
         init_try(n_try);
+        if ( n_try == first_try )
+            read_checkpoint();
+        checkpoint_at = elapsed_time( REAL ) + checkpoint_period;
 
         while ( !termination_condition() ) {
 
             construct_solutions();
             
-            if ( ls_flag > 0 ) {
-                for ( k = 0 ; k < n_ants ; k++ ) {
-                    copy_from_to( &ant[k], &prev_ls_ant[k] );
-                }
+            if ( ls_flag > 0 )
                 local_search();
-                for ( k = 0 ; k < n_ants ; k++ ) {                
-                    if (ant[k].fitness > prev_ls_ant[k].fitness ) {
-                        copy_from_to( &prev_ls_ant[k], &ant[k] );
-                    }
-                }                
-            }
             
             update_statistics();
 
@@ -516,7 +758,14 @@ int main(int argc, char *argv[]) {
             search_control_and_statistics();
     
             iteration++;
+
+            if ( checkpoint_period > 0. && elapsed_time( REAL ) >= checkpoint_at ) {
+                write_checkpoint();
+                checkpoint_at = elapsed_time( REAL ) + checkpoint_period;
+            }
         }
+        if ( stop_signal && ( checkpoint_period > 0. || resume_flag ) )
+            write_checkpoint();
         exit_try(n_try);
     }
     exit_program();
@@ -525,10 +774,15 @@ int main(int argc, char *argv[]) {
     free( instance.nn_list );
     free( pheromone );
     free( total );
+    free( heuristic );
+    free( row_epoch );
+    if ( ls_flag )
+        free_ls_workspaces();
     free( best_in_try );
     free( best_found_at );
     free( time_best_found );
     free( time_total_run );
+    free( evaluations_best_found );
     
     for ( i = 0 ; i < n_ants ; i++ ) {
         free( ant[i].tour );
@@ -557,6 +811,13 @@ int main(int argc, char *argv[]) {
     free( global_best_ant->packing_plan ); 
     
     free( prob_of_selection );
+
+    free( stat_pos );
+    free( stat_slot );
+    free( stat_neighbours );
+    free( stat_count );
+    free( stat_stamp );
         
-    return 0;
+    /* as a shell reports a process killed by the signal */
+    return stop_signal ? 128 + stop_signal : 0;
 }
@@ -73,6 +73,11 @@ ant_struct *global_best_ant;
 
 double   **pheromone;
 double   **total;
+double   **heuristic;  /* HEURISTIC(i,j) raised to beta; constant during a run */
+
+long int *row_epoch;       /* row i of pheromone and total is valid if row_epoch[i] == pheromone_epoch */
+long int pheromone_epoch;  /* incremented by each (re-)initialisation of the pheromone trails */
+double   epoch_trail;      /* initial trail of the current epoch */
 
 double   *prob_of_selection;
 
@@ -90,6 +95,11 @@ long int ras_flag;    /* rank-based version of ant system */
 long int mmas_flag;   /* MAX-MIN ant system */
 long int bwas_flag;   /* best-worst ant system */
 long int acs_flag;    /* ant colony system */
+long int paco_flag;   /* population-based ant colony optimization */
+
+long int partial_flag; /* time-bounded partial tour construction */
+
+long int acs_deferred_flag; /* ACS local pheromone updates at the end of each construction step */
 
 long int elitist_ants;    /* additional parameter for elitist ant system, no. elitist ants */
 
@@ -99,7 +109,28 @@ double   trail_max;       /* maximum pheromone trail in MMAS */
 double   trail_min;       /* minimum pheromone trail in MMAS */
 long int u_gb;            /* every u_gb iterations update with best-so-far ant */
 
-double   trail_0;         /* initial pheromone level in ACS and BWAS */
+double   trail_0;         /* initial pheromone level in ACS, BWAS and PACO */
+
+long int paco_size;          /* number of solutions in the population of PACO */
+long int **paco_population;  /* tours of the solutions in the population, a FIFO queue */
+long int paco_n;             /* number of solutions currently in the population */
+long int paco_oldest;        /* position of the oldest solution in paco_population */
+double   paco_delta;         /* pheromone that one solution of the population puts on its arcs */
+
+long int *active_arcs;       /* arcs i * n + j (i > j) whose pheromone is above trail_min; MMAS without local search */
+long int n_active_arcs;      /* number of arcs in active_arcs */
+long int max_active_arcs;    /* allocated length of active_arcs */
+char     *arc_is_active;     /* state of arc (i,j) in arc_is_active[i * n + j] and [j * n + i], see ARC_* */
+long int active_arcs_valid;  /* TRUE if active_arcs describes the current pheromone matrix */
+long int fused_update;       /* TRUE while deposits are collected for mmas_fused_pheromone_update */
+double   active_trail_min;   /* value of trail_min when active_arcs was built */
+
+long int *stat_pos;          /* positions of the cities in a tour, for distance_between_ants */
+long int *stat_slot;         /* index of a city among the cities sampled by population_statistics, or -1 */
+long int *stat_neighbours;   /* the two neighbours of each sampled city in the tour of each ant */
+long int *stat_count;        /* how often a city is among the neighbours of the current sampled city */
+long int *stat_stamp;        /* stat_count[c] is valid if stat_stamp[c] == stat_epoch */
+long int stat_epoch;
 
 
 /************************************************************
@@ -114,20 +145,58 @@ void init_pheromone_trails( double initial_trail )
       INPUT:         initial value of pheromone trails "initial_trail"
       OUTPUT:        none
       (SIDE)EFFECTS: pheromone matrix is reinitialized
+      COMMENTS:      the matrices are not written here; a new epoch is started 
+                     and each row is set to the initial trail (and the 
+                     corresponding total information) when it is accessed first, 
+                     see FRESH_ROW. A restart hence costs O(1) and rows that are 
+                     never used are never written
  */
 {
-    long int i, j;
-    
     TRACE ( printf(" init trails with %.15f\n",initial_trail); );
 
-    /* Initialize pheromone trails */
+    active_arcs_valid = FALSE;
+
+    pheromone_epoch++;
+    epoch_trail = initial_trail;
+}
+
+void refresh_pheromone_row( long int i )
+/*    
+      FUNCTION:      set a row that was not accessed since the last initialisation 
+                     of the pheromone trails to the initial trail
+      INPUT:         row index
+      OUTPUT:        none
+      (SIDE)EFFECTS: row i of pheromone and total is set, row i becomes valid
+      COMMENTS:      total is set as compute_total_information would do it
+ */
+{
+    long int j;
+    double   tau_alpha;
+    double   *p, *h, *t;
+
+    p = pheromone[i];
+    h = heuristic[i];
+    t = total[i];
+    tau_alpha = pow(epoch_trail, alpha);
+    for ( j = 0 ; j < instance.n ; j++ ) {
+        p[j] = epoch_trail;
+        t[j] = tau_alpha * h[j];
+    }
+    row_epoch[i] = pheromone_epoch;
+}
+
+void refresh_pheromone_rows( void )
+/*    
+      FUNCTION:      make all rows of pheromone and total valid
+      INPUT:         none
+      OUTPUT:        none
+      COMMENTS:      used before procedures that update all arcs
+ */
+{
+    long int i;
+
     for ( i = 0 ; i < instance.n ; i++ ) {
-        for ( j =0 ; j <= i ; j++ ) {
-            pheromone[i][j] = initial_trail;
-            pheromone[j][i] = initial_trail;
-            total[i][j] = initial_trail;
-            total[j][i] = initial_trail;
-        }
+        FRESH_ROW(i);
     }
 }
 
@@ -143,6 +212,8 @@ void evaporation( void )
 
     TRACE ( printf("pheromone evaporation\n"); );
 
+    refresh_pheromone_rows();
+
     for ( i = 0 ; i < instance.n ; i++ ) {
         for ( j = 0 ; j <= i ; j++ ) {
             pheromone[i][j] = (1 - rho) * pheromone[i][j];
@@ -166,6 +237,8 @@ void evaporation_nn_list( void )
 
     TRACE ( printf("pheromone evaporation nn_list\n"); );
 
+    refresh_pheromone_rows();
+
     for ( i = 0 ; i < instance.n ; i++ ) {
         for ( j = 0 ; j < nn_ants ; j++ ) {
             help_city = instance.nn_list[i][j];
@@ -191,6 +264,10 @@ void global_update_pheromone( ant_struct *a )
     for ( i = 0 ; i < instance.n ; i++ ) {
         j = a->tour[i];
         h = a->tour[i+1];
+        FRESH_ROW(j);
+        FRESH_ROW(h);
+        if ( active_arcs_valid || fused_update )
+            activate_arc( j, h );
         pheromone[j][h] += d_tau;
         pheromone[h][j] = pheromone[j][h];
     }
@@ -213,26 +290,87 @@ void global_update_pheromone_weighted( ant_struct *a, long int weight )
     for ( i = 0 ; i < instance.n ; i++ ) {
         j = a->tour[i];
         h = a->tour[i+1];
+        FRESH_ROW(j);
+        FRESH_ROW(h);
         pheromone[j][h] += d_tau;
         pheromone[h][j] = pheromone[j][h];
     }
 }
 
+void compute_heuristic_information( void )
+/*    
+      FUNCTION: calculates the heuristic information raised to beta for each arc
+      INPUT:    none  
+      OUTPUT:   none
+      (SIDE)EFFECTS: matrix heuristic is set
+ */
+{
+    long int     i, j;
+
+    TRACE ( printf("compute heuristic information\n"); );
+
+    for ( i = 0 ; i < instance.n ; i++ ) {
+        for ( j = 0 ; j < instance.n ; j++ ) {
+            heuristic[i][j] = pow(HEURISTIC(i,j),beta);
+        }
+    }
+}
+
 void compute_total_information( void )
 /*    
       FUNCTION: calculates heuristic info times pheromone for each arc
       INPUT:    none  
       OUTPUT:   none
+      COMMENTS: for alpha = 1 full rows are computed with unit stride, which the 
+                compiler vectorizes; otherwise the lower triangle is computed in 
+                tiles of TOTAL_BLOCK x TOTAL_BLOCK arcs and each tile is mirrored 
+                while it is still in cache. Rows (tile rows) are distributed over 
+                threads if compiled with OpenMP. Rows that were not accessed since 
+                the last initialisation of the trails are skipped, they get their 
+                total information when they are refreshed
  */
 {
-    long int     i, j;
+    long int     i, j, ib, jb, i_end, j_end;
+    double       *p, *h, *t;
 
     TRACE ( printf("compute total information\n"); );
 
-    for ( i = 0 ; i < instance.n ; i++ ) {
-        for ( j = 0 ; j < i ; j++ ) {
-            total[i][j] = pow(pheromone[i][j],alpha) * pow(HEURISTIC(i,j),beta);
-            total[j][i] = total[i][j];
+    if ( alpha == 1.0 ) {
+#ifdef _OPENMP
+#pragma omp parallel for private(j, p, h, t) schedule(static)
+#endif
+        for ( i = 0 ; i < instance.n ; i++ ) {
+            if ( row_epoch[i] != pheromone_epoch )
+                continue;
+            p = pheromone[i];
+            h = heuristic[i];
+            t = total[i];
+            for ( j = 0 ; j < instance.n ; j++ ) {
+                t[j] = p[j] * h[j];
+            }
+        }
+        return;
+    }
+#ifdef _OPENMP
+#pragma omp parallel for private(i, j, jb, i_end, j_end) schedule(dynamic)
+#endif
+    for ( ib = 0 ; ib < instance.n ; ib += TOTAL_BLOCK ) {
+        i_end = MIN(ib + TOTAL_BLOCK, instance.n);
+        for ( jb = 0 ; jb <= ib ; jb += TOTAL_BLOCK ) {
+            j_end = MIN(jb + TOTAL_BLOCK, instance.n);
+            for ( i = ib ; i < i_end ; i++ ) {
+                if ( row_epoch[i] != pheromone_epoch )
+                    continue;
+                for ( j = jb ; j < j_end && j < i ; j++ ) {
+                    total[i][j] = pow(pheromone[i][j],alpha) * heuristic[i][j];
+                }
+            }
+            for ( j = jb ; j < j_end ; j++ ) {
+                for ( i = MAX(ib, j + 1) ; i < i_end ; i++ ) {
+                    if ( row_epoch[i] == pheromone_epoch )
+                        total[j][i] = total[i][j];
+                }
+            }
         }
     }
 }
@@ -248,13 +386,15 @@ void compute_nn_list_total_information( void )
 
     TRACE ( printf("compute total information nn_list\n"); );
 
+    refresh_pheromone_rows();
+
     for ( i = 0 ; i < instance.n ; i++ ) {
         for ( j = 0 ; j < nn_ants ; j++ ) {
             h = instance.nn_list[i][j];
             if ( pheromone[i][h] < pheromone[h][i] )
                 /* force pheromone trails to be symmetric as much as possible */
                 pheromone[h][i] = pheromone[i][h];
-            total[i][h] = pow(pheromone[i][h], alpha) * pow(HEURISTIC(i,h),beta);
+            total[i][h] = pow(pheromone[i][h], alpha) * heuristic[i][h];
             total[h][i] = total[i][h];
         }
     }
@@ -279,9 +419,7 @@ void ant_empty_memory( ant_struct *a )
     for( i = 0 ; i < instance.n ; i++ ) {
         a->visited[i]=FALSE;
     }
-    for( i = 0 ; i < instance.m ; i++ ) {
-        a->packing_plan[i]=FALSE;
-    }
+    clear_bitset( a->packing_plan, instance.m );
 }
 
 void place_ant( ant_struct *a , long int step )
@@ -314,6 +452,7 @@ void choose_best_next( ant_struct *a, long int phase )
     next_city = instance.n;
     DEBUG( assert ( phase > 0 && phase < instance.n ); );
     current_city = a->tour[phase-1];
+    FRESH_ROW(current_city);
     value_best = -1.;             /* values in total matrix are always >= 0.0 */
     for ( city = 0 ; city < instance.n ; city++ ) {
         if ( a->visited[city] )
@@ -348,6 +487,7 @@ void neighbour_choose_best_next( ant_struct *a, long int phase )
     DEBUG( assert ( phase > 0 && phase < instance.n ); );
     current_city = a->tour[phase-1];
     DEBUG ( assert ( 0 <= current_city && current_city < instance.n ); )
+    FRESH_ROW(current_city);
     value_best = -1.;             /* values in total matix are always >= 0.0 */
     for ( i = 0 ; i < nn_ants ; i++ ) {
         help_city = instance.nn_list[current_city][i];
@@ -433,6 +573,7 @@ void neighbour_choose_and_move_to_next( ant_struct *a , long int phase )
 
     current_city = a->tour[phase-1]; /* current_city city of ant k */
     DEBUG( assert ( current_city >= 0 && current_city < instance.n ); )
+    FRESH_ROW(current_city);
     for ( i = 0 ; i < nn_ants ; i++ ) {
         if ( a->visited[instance.nn_list[current_city][i]] )
             prob_ptr[i] = 0.0;   /* city already visited */
@@ -475,6 +616,90 @@ void neighbour_choose_and_move_to_next( ant_struct *a , long int phase )
     }
 }
 
+long int time_bounded_move( ant_struct *a, long int phase )
+/*    
+      FUNCTION:      check whether the city chosen in construction step "phase" can 
+                     be reached (and city n-2 from it) within max_time when travelling 
+                     the constructed tour at max_speed; if not, replace it by the best 
+                     city that still can
+      INPUT:         pointer to ant and the construction step "phase" 
+      OUTPUT:        TRUE if the ant moved, FALSE if no unvisited city can be reached 
+                     in time and the ant stops its construction
+      (SIDE)EFFECT:  the travel time of the ant at max_speed is updated
+      COMMENTS:      the time of the constructed tour at max_speed (empty knapsack) 
+                     is a heuristic cutoff, not a lower bound: compute_fitness routes 
+                     the thief past the cities where no item is picked, so an ant 
+                     may be stopped although its tour could still pick items in 
+                     time. Only in the rare case the chosen city is out of reach 
+                     all cities are scanned
+ */
+{
+    long int city, current_city, next_city;
+    double   value_best, t;
+
+    current_city = a->tour[phase-1];
+    next_city = a->tour[phase];
+    t = a->time_max_speed + instance.distance[current_city][next_city] / instance.max_speed;
+    if ( t + instance.distance[next_city][instance.n - 2] / instance.max_speed - EPSILON <= instance.max_time ) {
+        a->time_max_speed = t;
+        return TRUE;
+    }
+
+    /* chosen city is out of reach, look for the best one that is not */
+    FRESH_ROW(current_city);
+    a->visited[next_city] = FALSE;
+    next_city = instance.n;
+    value_best = -1.;
+    for ( city = 0 ; city < instance.n ; city++ ) {
+        if ( a->visited[city] )
+            continue;
+        t = a->time_max_speed + ( instance.distance[current_city][city] + instance.distance[city][instance.n - 2] ) / instance.max_speed;
+        if ( t - EPSILON > instance.max_time )
+            continue;
+        if ( total[current_city][city] > value_best ) {
+            next_city = city;
+            value_best = total[current_city][city];
+        }
+    }
+    if ( next_city == instance.n )
+        return FALSE;
+
+    a->tour[phase] = next_city;
+    a->visited[next_city] = TRUE;
+    a->time_max_speed += instance.distance[current_city][next_city] / instance.max_speed;
+    return TRUE;
+}
+
+void complete_tour( ant_struct *a )
+/*    
+      FUNCTION:      append the cities not chosen in construction to the tour
+      INPUT:         pointer to ant
+      OUTPUT:        none 
+      (SIDE)EFFECT:  positions n_constructed+1 .. n-3 of the tour are filled in one 
+                     pass, first with the unvisited cities in index order and then 
+                     with the pruned cities if --reduce is used
+ */
+{
+    long int i, pos;
+
+    if ( a->n_constructed == instance.n - 3 )
+        return;  /* tour is complete */
+
+    pos = a->n_constructed + 1;
+    for ( i = 1 ; i < instance.n - 2 ; i++ ) {
+        if ( !a->visited[i] ) {
+            a->tour[pos++] = i;
+            a->visited[i] = TRUE;
+        }
+    }
+    if ( reduce_flag ) {
+        for ( i = 0 ; i < instance.n_pruned ; i++ ) {
+            a->tour[pos++] = instance.pruned_cities[i];
+        }
+    }
+    DEBUG( assert ( pos == instance.n - 2 ); )
+}
+
 /**************************************************************************
  **************************************************************************
 Procedures specific to the ant's tour manipulation other than construction
@@ -536,14 +761,14 @@ void copy_from_to(ant_struct *a1, ant_struct *a2)
     int   i;
 
     a2->fitness = a1->fitness;
+    a2->n_constructed = a1->n_constructed;
+    a2->time_max_speed = a1->time_max_speed;
     for ( i = 0 ; i < instance.n ; i++ ) {
         a2->tour[i] = a1->tour[i];
     }
     a2->tour[instance.n] = a2->tour[0];
     
-    for ( i = 0 ; i < instance.m ; i++ ) {
-        a2->packing_plan[i] = a1->packing_plan[i];
-    }
+    copy_bitset( a1->packing_plan, a2->packing_plan, instance.m );
     
     for ( i = 0 ; i < instance.n ; i++ ) {
         a2->visited[i] = a1->visited[i];
@@ -568,7 +793,7 @@ void allocate_ants ( void )
     }
     for ( i = 0 ; i < n_ants ; i++ ) {
         ant[i].tour         = calloc(instance.n + 1, sizeof(long int));
-        ant[i].packing_plan = calloc(instance.m + 1, sizeof(char));
+        ant[i].packing_plan = generate_bitset(instance.m);
         ant[i].visited      = calloc(instance.n, sizeof(char));
     }
     
@@ -579,7 +804,7 @@ void allocate_ants ( void )
     }
     for ( i = 0 ; i < n_ants ; i++ ) {
         prev_ls_ant[i].tour         = calloc(instance.n + 1, sizeof(long int));
-        prev_ls_ant[i].packing_plan = calloc(instance.m + 1, sizeof(char));
+        prev_ls_ant[i].packing_plan = generate_bitset(instance.m);
         prev_ls_ant[i].visited      = calloc(instance.n, sizeof(char));
     }
 
@@ -588,7 +813,7 @@ void allocate_ants ( void )
         exit(1);
     }
     best_so_far_ant->tour           = calloc(instance.n + 1, sizeof(long int));
-    best_so_far_ant->packing_plan   = calloc(instance.m, sizeof(char));
+    best_so_far_ant->packing_plan   = generate_bitset(instance.m);
     best_so_far_ant->visited        = calloc(instance.n, sizeof(char));
     
     if((restart_best_ant = malloc(sizeof( ant_struct ) )) == NULL){
@@ -596,7 +821,7 @@ void allocate_ants ( void )
         exit(1);
     }
     restart_best_ant->tour           = calloc(instance.n + 1, sizeof(long int));
-    restart_best_ant->packing_plan   = calloc(instance.m, sizeof(char));
+    restart_best_ant->packing_plan   = generate_bitset(instance.m);
     restart_best_ant->visited        = calloc(instance.n, sizeof(char));
     
     if((global_best_ant = malloc(sizeof( ant_struct ) )) == NULL){
@@ -605,7 +830,7 @@ void allocate_ants ( void )
     }
         
     global_best_ant->tour           = calloc(instance.n + 1, sizeof(long int));
-    global_best_ant->packing_plan   = calloc(instance.m, sizeof(char));
+    global_best_ant->packing_plan   = generate_bitset(instance.m);
     global_best_ant->visited        = calloc(instance.n, sizeof(char));    
     global_best_ant->fitness = INFTY;    
 
@@ -615,6 +840,18 @@ void allocate_ants ( void )
     }
     /* Ensures that we do not run over the last element in the random wheel.  */
     prob_of_selection[nn_ants] = HUGE_VAL;
+
+    /* workspace of population_statistics and distance_between_ants */
+    stat_pos = malloc(instance.n * sizeof(long int));
+    stat_slot = malloc(instance.n * sizeof(long int));
+    stat_count = malloc(instance.n * sizeof(long int));
+    stat_stamp = calloc(instance.n, sizeof(long int));
+    stat_neighbours = malloc(2 * MIN(instance.n, STAT_SAMPLE) * n_ants * sizeof(long int));
+    stat_epoch = 0;
+    for ( i = 0 ; i < instance.n ; i++ )
+        stat_slot[i] = -1;
+    for ( i = 0 ; i < MIN(instance.n, STAT_SAMPLE) ; i++ )
+        stat_slot[i * instance.n / MIN(instance.n, STAT_SAMPLE)] = i;
 }
 
 long int nn_tour( void )
@@ -650,14 +887,16 @@ long int nn_tour( void )
         case 0:
             break;
         case 1:
-            two_opt_first( ant[0].tour, instance.n );    /* 2-opt local search */
+            two_opt_first( ant[0].tour, instance.n, ls_workspaces[0] );    /* 2-opt local search */
             break;
         case 2:
-            two_h_opt_first( ant[0].tour, instance.n );  /* 2.5-opt local search */
+            two_h_opt_first( ant[0].tour, instance.n, ls_workspaces[0] );  /* 2.5-opt local search */
             break;
         case 3:
-            three_opt_first( ant[0].tour, instance.n );  /* 3-opt local search */
+            three_opt_first( ant[0].tour, instance.n, ls_workspaces[0] );  /* 3-opt local search */
             break;
+        case 4:
+            break;  /* ThOP local search, applied below to the packing plan */
         default:
             fprintf(stderr,"type of local search procedure not correctly specified\n");
             exit(1);
@@ -665,7 +904,10 @@ long int nn_tour( void )
 
     n_tours += 1;
 
-    ant[0].fitness = compute_fitness( ant[0].tour, ant[0].packing_plan);
+    ant[0].n_constructed = instance.n - 3;
+    ant[0].fitness = compute_fitness( ant[0].tour, ant[0].packing_plan, ant[0].n_constructed );
+    if ( ls_flag == 4 )
+        thop_local_search( &ant[0], ls_workspaces[0] );
     copy_from_to( &ant[0], best_so_far_ant );    
     
     help = ant[0].fitness;
@@ -682,9 +924,8 @@ long int distance_between_ants( ant_struct *a1, ant_struct *a2)
 {  
     long int    i, j, h, pos, pred;
     long int    distance;
-    long int    *pos2;        /* positions of cities in tour of ant a2 */
+    long int    *pos2 = stat_pos;  /* positions of cities in tour of ant a2 */
 
-    pos2 = malloc(instance.n * sizeof(long int));
     for ( i = 0 ; i < instance.n ; i++ ) {
         pos2[a2->tour[i]] = i;
     }
@@ -706,40 +947,72 @@ long int distance_between_ants( ant_struct *a1, ant_struct *a2)
             distance++;
         }
     }
-    free ( pos2 );
     return distance;
 }
 
 void population_statistics(void)
 /*    
-      FUNCTION:       compute some population statistics like average tour length, 
-                      standard deviations, average distance, branching-factor and 
-              output to a file gathering statistics
+      FUNCTION:       compute some population statistics like average fitness, 
+                      standard deviation, average distance between the tours and 
+                      branching-factor
       INPUT:          none
       OUTPUT:         none
-      (SIDE)EFFECTS:  none
+      (SIDE)EFFECTS:  mean_ants, stddev_ants, distance_ants and branching_factor 
+                      are set; they are written to the log file
+      COMMENTS:       the average distance is computed from arc frequencies 
+                      instead of comparing all pairs of ants: if f ants share an 
+                      arc, f(f-1)/2 pairs of ants have it in common. The arcs at 
+                      up to STAT_SAMPLE evenly spread cities are counted, which 
+                      takes O(n_ants * n) time and no allocation; each arc has two 
+                      end points, hence half of the extrapolated count is the 
+                      number of arcs shared by all pairs
  */
 {
-    long int j, k;
-    long int * l;
-    double pop_mean, pop_stddev, avg_distance = 0.0;
-
-    l = malloc(n_ants * sizeof(long int));
-    for (k = 0; k < n_ants; k++) {
-        l[k] = ant[k].fitness;
+    long int i, k, s, c, *t;
+    const long int n = instance.n;
+    const long int n_sample = MIN(n, STAT_SAMPLE);
+    double sum = 0., sum_sq = 0., shared = 0., pairs;
+
+    for ( k = 0 ; k < n_ants ; k++ ) {
+        sum += (double) ant[k].fitness;
+        sum_sq += (double) ant[k].fitness * (double) ant[k].fitness;
     }
-
-    pop_mean = mean(l, n_ants);
-    pop_stddev = std_deviation(l, n_ants, pop_mean);
+    mean_ants = sum / (double) n_ants;
+    stddev_ants = n_ants > 1 ? 
+        sqrt( MAX(0., sum_sq - sum * mean_ants) / (double) (n_ants - 1) ) : 0.;
     branching_factor = node_branching(lambda);
 
-    for (k = 0; k < n_ants - 1; k++)
-        for (j = k + 1; j < n_ants; j++) {
-            avg_distance += (double) distance_between_ants( & ant[k], & ant[j]);
+    /* neighbours of the sampled cities in the tour of each ant */
+    for ( k = 0 ; k < n_ants ; k++ ) {
+        t = ant[k].tour;
+        for ( i = 0 ; i < n ; i++ ) {
+            s = stat_slot[t[i]];
+            if ( s >= 0 ) {
+                stat_neighbours[2 * (s * n_ants + k)] = t[i + 1];
+                stat_neighbours[2 * (s * n_ants + k) + 1] = i > 0 ? t[i - 1] : t[n - 1];
+            }
         }
-    avg_distance /= ((double) n_ants * (double)(n_ants - 1) / 2.);
-
-    free(l);
+    }
+    for ( s = 0 ; s < n_sample ; s++ ) {
+        stat_epoch++;
+        for ( i = 0 ; i < 2 * n_ants ; i++ ) {
+            c = stat_neighbours[2 * s * n_ants + i];
+            if ( stat_stamp[c] != stat_epoch ) {
+                stat_stamp[c] = stat_epoch;
+                stat_count[c] = 0;
+            }
+            shared += (double) stat_count[c]++;
+        }
+    }
+    pairs = (double) n_ants * (double) (n_ants - 1) / 2.;
+    distance_ants = n_ants > 1 ? 
+        (double) n - 0.5 * shared * (double) n / (double) n_sample / pairs : 0.;
+
+    if ( log_file ) {
+        fprintf(log_file, "statistics iteration %10ld,        mean %12.1f,        stddev %12.1f,        distance %8.1f,        branching %.5f\n", 
+                iteration, (double) (instance.UB + 1) - mean_ants, stddev_ants, distance_ants, branching_factor);
+        fflush(log_file);
+    }
 }
 
 double node_branching(double l)
@@ -755,11 +1028,10 @@ double node_branching(double l)
     long int i, m;
     double min, max, cutoff;
     double avg;
-    double * num_branches;
-
-    num_branches = calloc(instance.n, sizeof(double));
 
+    avg = 0.;
     for (m = 0; m < instance.n; m++) {
+        FRESH_ROW(m);
         /* determine max, min to calculate the cutoff value */
         min = pheromone[m][instance.nn_list[m][1]];
         max = pheromone[m][instance.nn_list[m][1]];
@@ -773,14 +1045,9 @@ double node_branching(double l)
 
         for (i = 0; i < nn_ants; i++) {
             if (pheromone[m][instance.nn_list[m][i]] > cutoff)
-                num_branches[m] += 1.;
+                avg += 1.;
         }
     }
-    avg = 0.;
-    for (m = 0; m < instance.n; m++) {
-        avg += num_branches[m];
-    }
-    free(num_branches);
     /* Norm branching factor to minimal value 1 */
     return (avg / (double)(instance.n * 2));
 }
@@ -805,6 +1072,8 @@ void mmas_evaporation_nn_list( void )
 
     TRACE ( printf("mmas specific evaporation on nn_lists\n"); );
 
+    refresh_pheromone_rows();
+
     for ( i = 0 ; i < instance.n ; i++ ) {
         for ( j = 0 ; j < nn_ants ; j++ ) {
             help_city = instance.nn_list[i][j];
@@ -831,6 +1100,8 @@ void check_nn_list_pheromone_trail_limits( void )
 
     TRACE ( printf("mmas specific: check pheromone trail limits nn_list\n"); );
 
+    refresh_pheromone_rows();
+
     for ( i = 0 ; i < instance.n ; i++ ) {
         for ( j = 0 ; j < nn_ants ; j++ ) {
             help_city = instance.nn_list[i][j];
@@ -842,6 +1113,245 @@ void check_nn_list_pheromone_trail_limits( void )
     }
 }
 
+static void add_active_arc( long int k )
+/*    
+      FUNCTION:      append arc k = i * n + j (i > j) to the list of active arcs
+      INPUT:         arc index
+      OUTPUT:        none
+ */
+{
+    if ( n_active_arcs == max_active_arcs ) {
+        max_active_arcs = 2 * max_active_arcs + instance.n;
+        active_arcs = realloc(active_arcs, max_active_arcs * sizeof(long int));
+        if ( active_arcs == NULL ) {
+            fprintf(stderr, "Out of memory, exit.");
+            exit(1);
+        }
+    }
+    active_arcs[n_active_arcs++] = k;
+}
+
+void activate_arc( long int i, long int j )
+/*    
+      FUNCTION:      mark an arc that is going to receive pheromone as changed
+      INPUT:         the two end points of the arc
+      OUTPUT:        none
+      (SIDE)EFFECTS: the pheromone of an arc that has not been evaporated yet is 
+                     set to (1 - rho) times its value, as evaporation() would do; 
+                     with active_arcs_valid, an inactive arc is added to active_arcs
+      COMMENTS:      with fused_update no arc has been evaporated yet; the arcs 
+                     marked ARC_CHANGED form the sparse deposit list of 
+                     mmas_fused_pheromone_update
+ */
+{
+    long int k;
+
+    if ( i < j ) {
+        k = i; i = j; j = k;
+    }
+    k = i * instance.n + j;
+    if ( arc_is_active[k] == ARC_CHANGED )
+        return;
+    if ( fused_update || arc_is_active[k] == ARC_INACTIVE ) {
+        pheromone[i][j] = (1 - rho) * pheromone[i][j];
+        pheromone[j][i] = pheromone[i][j];
+    }
+    if ( !fused_update && arc_is_active[k] == ARC_INACTIVE )
+        add_active_arc( k );
+    arc_is_active[k] = arc_is_active[j * instance.n + i] = ARC_CHANGED;
+}
+
+void allocate_arc_states( void )
+/*    
+      FUNCTION:      allocate the arc states used by the pheromone update of MMAS 
+                     without local search
+      INPUT:         none
+      OUTPUT:        none
+      (SIDE)EFFECTS: arc_is_active is allocated, all arcs are ARC_INACTIVE
+ */
+{
+    arc_is_active = calloc(instance.n * instance.n, sizeof(char));
+    if ( arc_is_active == NULL ) {
+        fprintf(stderr, "Out of memory, exit.");
+        exit(1);
+    }
+    n_active_arcs = 0;
+    active_arcs_valid = FALSE;
+    fused_update = FALSE;
+}
+
+void build_active_arcs( void )
+/*    
+      FUNCTION:      only for MMAS without local search: collect the arcs whose 
+                     pheromone is above trail_min
+      INPUT:         none
+      OUTPUT:        none
+      (SIDE)EFFECTS: active_arcs is set from arc_is_active, active_arcs becomes valid
+      COMMENTS:      all other arcs are exactly at trail_min; evaporation followed 
+                     by check_pheromone_trail_limits leaves them unchanged, so 
+                     only the active arcs need to be updated as long as trail_min 
+                     does not change. Requires the arc states set by 
+                     mmas_fused_pheromone_update
+ */
+{
+    long int i, j;
+
+    n_active_arcs = 0;
+    for ( i = 0 ; i < instance.n ; i++ ) {
+        for ( j = 0 ; j < i ; j++ ) {
+            if ( arc_is_active[i * instance.n + j] == ARC_ACTIVE )
+                add_active_arc( i * instance.n + j );
+        }
+    }
+    active_trail_min = trail_min;
+    active_arcs_valid = TRUE;
+}
+
+void mmas_fused_pheromone_update( void )
+/*    
+      FUNCTION:      only for MMAS without local search: evaporation, trail limits 
+                     and total information of all arcs in a single sweep
+      INPUT:         none
+      OUTPUT:        none
+      (SIDE)EFFECTS: pheromones are evaporated and forced to [trail_min,trail_max], 
+                     total is recomputed, arc_is_active is set for all arcs
+      COMMENTS:      replaces evaporation(), check_pheromone_trail_limits() and 
+                     compute_total_information(); the deposit has to be done 
+                     before with fused_update set, so that the deposited arcs are 
+                     evaporated in activate_arc and marked ARC_CHANGED. Both 
+                     triangles are computed row by row with unit stride instead of 
+                     mirroring the lower one; the loop body has no branches and 
+                     is vectorized by the compiler. Rows that were not accessed 
+                     since the last initialisation of the trails are evaporated 
+                     from the initial trail without reading them
+ */
+{
+    long int     i, j;
+    double       tau, evap, stale_tau, stale_total;
+    double       *p, *h, *t;
+    char         *state;
+
+    TRACE ( printf("mmas specific: fused pheromone update\n"); );
+
+    evap = 1 - rho;
+#ifdef _OPENMP
+#pragma omp parallel for private(j, tau, stale_tau, stale_total, p, h, t, state) schedule(static)
+#endif
+    for ( i = 0 ; i < instance.n ; i++ ) {
+        p = pheromone[i];
+        h = heuristic[i];
+        t = total[i];
+        state = arc_is_active + i * instance.n;
+        if ( row_epoch[i] != pheromone_epoch ) {
+            /* no arc of the row received a deposit */
+            stale_tau = evap * epoch_trail;
+            stale_tau = ( stale_tau < trail_min ) ? trail_min : stale_tau;
+            stale_tau = ( stale_tau > trail_max ) ? trail_max : stale_tau;
+            stale_total = pow(stale_tau, alpha);
+            for ( j = 0 ; j < instance.n ; j++ ) {
+                p[j] = stale_tau;
+                t[j] = stale_total * h[j];
+                state[j] = ( stale_tau > trail_min ) ? ARC_ACTIVE : ARC_INACTIVE;
+            }
+            row_epoch[i] = pheromone_epoch;
+        }
+        else if ( alpha == 1.0 ) {
+            for ( j = 0 ; j < instance.n ; j++ ) {
+                tau = ( state[j] == ARC_CHANGED ) ? p[j] : evap * p[j];
+                tau = ( tau < trail_min ) ? trail_min : tau;
+                tau = ( tau > trail_max ) ? trail_max : tau;
+                p[j] = tau;
+                t[j] = tau * h[j];
+                state[j] = ( tau > trail_min ) ? ARC_ACTIVE : ARC_INACTIVE;
+            }
+        }
+        else {
+            for ( j = 0 ; j < instance.n ; j++ ) {
+                tau = ( state[j] == ARC_CHANGED ) ? p[j] : evap * p[j];
+                tau = ( tau < trail_min ) ? trail_min : tau;
+                tau = ( tau > trail_max ) ? trail_max : tau;
+                p[j] = tau;
+                t[j] = pow(tau, alpha) * h[j];
+                state[j] = ( tau > trail_min ) ? ARC_ACTIVE : ARC_INACTIVE;
+            }
+        }
+    }
+}
+
+void mmas_evaporation_active_arcs( void )
+/*    
+      FUNCTION:      only for MMAS without local search: pheromone evaporation 
+                     restricted to the active arcs
+      INPUT:         none
+      OUTPUT:        none
+      (SIDE)EFFECTS: pheromones of active arcs are reduced by factor rho
+ */
+{
+    long int k, i, j;
+
+    TRACE ( printf("mmas specific: evaporation of active arcs\n"); );
+
+    for ( k = 0 ; k < n_active_arcs ; k++ ) {
+        i = active_arcs[k] / instance.n;
+        j = active_arcs[k] % instance.n;
+        pheromone[i][j] = (1 - rho) * pheromone[i][j];
+        pheromone[j][i] = pheromone[i][j];
+    }
+}
+
+void mmas_update_active_arcs( void )
+/*    
+      FUNCTION:      only for MMAS without local search: trail limits and total 
+                     information of the active arcs after evaporation and deposit
+      INPUT:         none
+      OUTPUT:        none
+      (SIDE)EFFECTS: pheromones of active arcs are forced to [trail_min,trail_max], 
+                     arcs that reach trail_min are removed from active_arcs and 
+                     total is recomputed for all arcs that were active
+      COMMENTS:      for alpha = 1 total is recomputed exactly; otherwise arcs that 
+                     only evaporated are scaled analytically by (1 - rho)^alpha and 
+                     pow is called only for arcs that received a deposit or hit a 
+                     trail limit
+ */
+{
+    long int k, i, j;
+    double   decay, tau;
+
+    TRACE ( printf("mmas specific: trail limits and total information of active arcs\n"); );
+
+    decay = pow(1 - rho, alpha);
+    for ( k = 0 ; k < n_active_arcs ; ) {
+        i = active_arcs[k] / instance.n;
+        j = active_arcs[k] % instance.n;
+        tau = pheromone[i][j];
+        if ( tau < trail_min ) {
+            tau = trail_min;
+            arc_is_active[active_arcs[k]] = ARC_CHANGED;
+        }
+        else if ( tau > trail_max ) {
+            tau = trail_max;
+            arc_is_active[active_arcs[k]] = ARC_CHANGED;
+        }
+        /* arc_is_active is symmetric, the state of (i,j) is kept in both entries */
+        pheromone[i][j] = pheromone[j][i] = tau;
+        if ( alpha == 1.0 )
+            total[i][j] = tau * heuristic[i][j];
+        else if ( arc_is_active[active_arcs[k]] == ARC_CHANGED )
+            total[i][j] = pow(tau, alpha) * heuristic[i][j];
+        else
+            total[i][j] *= decay;
+        total[j][i] = total[i][j];
+        if ( tau <= trail_min ) {
+            arc_is_active[active_arcs[k]] = arc_is_active[j * instance.n + i] = ARC_INACTIVE;
+            active_arcs[k] = active_arcs[--n_active_arcs];
+        }
+        else {
+            arc_is_active[active_arcs[k]] = arc_is_active[j * instance.n + i] = ARC_ACTIVE;
+            k++;
+        }
+    }
+}
+
 void check_pheromone_trail_limits( void )
 /*    
       FUNCTION:      only for MMAS without local search: 
@@ -855,6 +1365,8 @@ void check_pheromone_trail_limits( void )
 
     TRACE ( printf("mmas specific: check pheromone trail limits\n"); );
 
+    refresh_pheromone_rows();
+
     for ( i = 0 ; i < instance.n ; i++ ) {
         for ( j = 0 ; j < i ; j++ ) {
             if ( pheromone[i][j] < trail_min ) {
@@ -894,10 +1406,12 @@ void global_acs_pheromone_update( ant_struct *a )
         j = a->tour[i];
         h = a->tour[i+1];
 
+        FRESH_ROW(j);
+        FRESH_ROW(h);
         pheromone[j][h] = (1. - rho) * pheromone[j][h] + rho * d_tau;
         pheromone[h][j] = pheromone[j][h];
 
-        total[h][j] = pow(pheromone[h][j], alpha) * pow(HEURISTIC(h,j),beta);
+        total[h][j] = pow(pheromone[h][j], alpha) * heuristic[h][j];
         total[j][h] = total[h][j];
     }
 }
@@ -924,12 +1438,56 @@ void local_acs_pheromone_update( ant_struct *a, long int phase )
     DEBUG ( assert ( 0 <= j && j < instance.n ); )
     DEBUG ( assert ( 0 <= h && h < instance.n ); )
     /* still additional parameter has to be introduced */
+    FRESH_ROW(j);
+    FRESH_ROW(h);
     pheromone[h][j] = (1. - 0.1) * pheromone[h][j] + 0.1 * trail_0;
     pheromone[j][h] = pheromone[h][j];
-    total[h][j] = pow(pheromone[h][j], alpha) * pow(HEURISTIC(h,j),beta);
+    total[h][j] = pow(pheromone[h][j], alpha) * heuristic[h][j];
     total[j][h] = total[h][j];
 }
 
+void deferred_local_acs_pheromone_update( long int phase )
+/*    
+      FUNCTION:      applies the local pheromone updates of all ants that moved in 
+                     construction step "phase"
+      INPUT:         number of construction step
+      OUTPUT:        none
+      (SIDE)EFFECTS: pheromones and total information of the arcs (tour[phase-1], 
+                     tour[phase]) of the ants are updated
+      COMMENTS:      with --deferred the ants of a step do not see the local updates 
+                     of the other ants in the same step. construct_solutions makes all 
+                     rows valid before the first step, so FRESH_ROW does not write in 
+                     the steps and the ants only read pheromone and total; they still 
+                     share the random number stream seed. The arcs of the ants (the 
+                     update log of the step) are merged here in ant order. The 
+                     pheromones are updated first and total is computed once 
+                     afterwards; arcs used by several ants are evaporated once per 
+                     ant as in the immediate update. For phase n all ants update 
+                     their closing arc
+ */
+{
+    long int  k, h, j;
+
+    for ( k = 0 ; k < n_ants ; k++ ) {
+        if ( phase < instance.n && ant[k].n_constructed < phase )
+            continue;   /* ant did not move in this step */
+        j = ant[k].tour[phase];
+        h = ant[k].tour[phase-1];
+        FRESH_ROW(j);
+        FRESH_ROW(h);
+        pheromone[h][j] = (1. - 0.1) * pheromone[h][j] + 0.1 * trail_0;
+        pheromone[j][h] = pheromone[h][j];
+    }
+    for ( k = 0 ; k < n_ants ; k++ ) {
+        if ( phase < instance.n && ant[k].n_constructed < phase )
+            continue;
+        j = ant[k].tour[phase];
+        h = ant[k].tour[phase-1];
+        total[h][j] = ( alpha == 1.0 ) ? pheromone[h][j] * heuristic[h][j] : pow(pheromone[h][j], alpha) * heuristic[h][j];
+        total[j][h] = total[h][j];
+    }
+}
+
 /****************************************************************
  ****************************************************************
 Procedures specific to Best-Worst Ant System
@@ -970,6 +1528,8 @@ void bwas_worst_ant_update( ant_struct *a1, ant_struct *a2)
         else if (a2->tour[pred] == h)
             ; /* do nothing, edge is common with a2 (best solution found so far) */
         else {   /* edge (j,h) does not occur in ant a2 */
+            FRESH_ROW(j);
+            FRESH_ROW(h);
             pheromone[j][h] = (1 - rho) * pheromone[j][h];
             pheromone[h][j] = (1 - rho) * pheromone[h][j];
         }
@@ -992,6 +1552,7 @@ void bwas_pheromone_mutation( void )
 
     /* compute average pheromone trail on edges of global best solution */
     for ( i = 0 ; i < instance.n ; i++ ) {
+        FRESH_ROW(best_so_far_ant->tour[i]);
         avg_trail +=  pheromone[best_so_far_ant->tour[i]][best_so_far_ant->tour[i+1]];
     }
     avg_trail /= (double) instance.n;
@@ -1001,7 +1562,7 @@ void bwas_pheromone_mutation( void )
        potential division by zero. This may not be fully correct
        according to the original BWAS. */
     if ( max_time > 0.1 )
-        mutation_strength = 4. * avg_trail * (elapsed_time(VIRTUAL) - restart_time) / (max_time - restart_time + 0.0001);
+        mutation_strength = 4. * avg_trail * (elapsed_time(budget_timer) - restart_time) / (max_time - restart_time + 0.0001);
     else if ( max_tours > 100 )
         mutation_strength = 4. * avg_trail * (iteration - restart_iteration)
         / (max_tours - restart_iteration + 1);
@@ -1019,6 +1580,8 @@ void bwas_pheromone_mutation( void )
     for ( i = 0 ; i < num_mutations ; i++ ) {
         j =   (long int) (ran01( &seed ) * (double) instance.n);
         k =   (long int) (ran01( &seed ) * (double) instance.n);
+        FRESH_ROW(j);
+        FRESH_ROW(k);
         if ( ran01( &seed ) < 0.5 ) {
             pheromone[j][k] += mutation_strength;
             pheromone[k][j] = pheromone[j][k];
@@ -1032,3 +1595,79 @@ void bwas_pheromone_mutation( void )
         }
     }
 }
+
+/****************************************************************
+ ****************************************************************
+Procedures specific to population-based ACO
+ ****************************************************************
+ ****************************************************************/
+
+void paco_init_population( void )
+/*    
+      FUNCTION:      empty the population of PACO
+      INPUT:         none
+      OUTPUT:        none
+      (SIDE)EFFECTS: the population is allocated on first use and emptied
+      COMMENTS:      the pheromone trails have to be initialised with trail_0 
+                     separately
+ */
+{
+    if ( paco_population == NULL )
+        paco_population = generate_int_matrix( paco_size, instance.n + 1 );
+    paco_n = 0;
+    paco_oldest = 0;
+}
+
+void paco_pheromone_update( long int *tour, long int sign )
+/*    
+      FUNCTION:      add (sign = 1) or remove (sign = -1) the contribution of a 
+                     solution of the population to the pheromone trails
+      INPUT:         tour of the solution, sign
+      OUTPUT:        none
+      (SIDE)EFFECTS: pheromone and total of the arcs of the tour are updated
+      COMMENTS:      the trail of an arc is trail_0 plus paco_delta times the 
+                     number of solutions in the population that contain the arc; 
+                     the number is recovered from the trail and the trail is set 
+                     from it, so that additions and removals do not accumulate 
+                     rounding errors
+ */
+{
+    long int i, j, h, count;
+
+    for ( i = 0 ; i < instance.n ; i++ ) {
+        j = tour[i];
+        h = tour[i+1];
+        FRESH_ROW(j);
+        FRESH_ROW(h);
+        count = (long int) ( ( pheromone[j][h] - trail_0 ) / paco_delta + 0.5 ) + sign;
+        pheromone[j][h] = trail_0 + paco_delta * (double) count;
+        pheromone[h][j] = pheromone[j][h];
+        total[j][h] = pow(pheromone[j][h], alpha) * heuristic[j][h];
+        total[h][j] = total[j][h];
+    }
+}
+
+void paco_population_update( ant_struct *a )
+/*    
+      FUNCTION:      insert a solution into the population of PACO
+      INPUT:         pointer to the ant whose solution enters the population
+      OUTPUT:        none
+      (SIDE)EFFECTS: if the population is full, the oldest solution leaves it; 
+                     pheromone and total are updated for the arcs of the two 
+                     solutions only
+ */
+{
+    long int i;
+
+    TRACE ( printf("paco specific: population update\n"); );
+
+    if ( paco_n == paco_size )
+        paco_pheromone_update( paco_population[paco_oldest], -1 );
+    else
+        paco_n++;
+    for ( i = 0 ; i <= instance.n ; i++ ) {
+        paco_population[paco_oldest][i] = a->tour[i];
+    }
+    paco_pheromone_update( paco_population[paco_oldest], 1 );
+    paco_oldest = ( paco_oldest + 1 ) % paco_size;
+}
@@ -61,15 +61,27 @@ zero */
 #define MAX_ANTS       1024    /* max no. of ants */
 #define MAX_NEIGHBOURS 512     /* max. no. of nearest neighbours in candidate set */
 
+#define TOTAL_BLOCK    64      /* tile size of compute_total_information */
+#define STAT_SAMPLE    256     /* cities sampled by population_statistics */
+
+/* make row i of pheromone and total valid before it is accessed, see init_pheromone_trails */
+#define FRESH_ROW(i)   do { if ( row_epoch[i] != pheromone_epoch ) refresh_pheromone_row(i); } while (0)
+
+#define ARC_INACTIVE   0       /* states of arc_is_active */
+#define ARC_ACTIVE     1
+#define ARC_CHANGED    2       /* active and received a deposit or hit a trail limit */
+
 /* Note that *tour needs to be allocated for length n+1 since the first city of 
 a tour (at position 0) is repeated at position n. This is done to make the 
 computation of the tour length easier 
  */
 typedef struct {
     long int  *tour;
-    char      *packing_plan;
+    unsigned long int *packing_plan;  /* bitset over the items, see BITSET_* macros */
     char      *visited;
     long int  fitness;
+    long int  n_constructed;  /* tour[1..n_constructed] were chosen in construction, the rest is appended */
+    double    time_max_speed; /* travel time of the constructed part of the tour at max_speed, see time_bounded_move */
 } ant_struct;
 
 extern ant_struct *ant;               /* this (array of) struct will hold the colony */
@@ -80,6 +92,11 @@ extern ant_struct *global_best_ant;   /* struct that contains the global-best an
 
 extern double   **pheromone; /* pheromone matrix, one entry for each arc */
 extern double   **total;     /* combination of pheromone times heuristic information */
+extern double   **heuristic; /* heuristic information raised to beta */
+
+extern long int *row_epoch;       /* row i of pheromone and total is valid if row_epoch[i] == pheromone_epoch */
+extern long int pheromone_epoch;  /* incremented by each (re-)initialisation of the pheromone trails */
+extern double   epoch_trail;      /* initial trail of the current epoch */
 
 extern double   *prob_of_selection;
 
@@ -98,6 +115,11 @@ extern long int ras_flag;    /* = 1, run rank-based version of ant system */
 extern long int mmas_flag;   /* = 1, run MAX-MIN ant system */
 extern long int bwas_flag;   /* = 1, run best-worst ant system */
 extern long int acs_flag;    /* = 1, run ant colony system */
+extern long int paco_flag;   /* = 1, run population-based ant colony optimization */
+
+extern long int partial_flag; /* = 1, stop construction once max_time is exhausted */
+
+extern long int acs_deferred_flag; /* = 1, apply ACS local pheromone updates at the end of each construction step */
 
 extern long int elitist_ants;    /* additional parameter for elitist ant system, it defines the number of elitist ants */
 
@@ -107,12 +129,36 @@ extern double   trail_max;       /* maximum pheromone trail in MMAS */
 extern double   trail_min;       /* minimum pheromone trail in MMAS */
 extern long int u_gb;            /* every u_gb iterations update with best-so-far ant; parameter used by MMAS for scheduling best-so-far update */
 
-extern double   trail_0;         /* initial pheromone trail level in ACS  and BWAS */
+extern double   trail_0;         /* initial pheromone trail level in ACS, BWAS and PACO */
+
+extern long int paco_size;          /* number of solutions in the population of PACO */
+extern long int **paco_population;  /* tours of the solutions in the population, a FIFO queue */
+extern long int paco_n;             /* number of solutions currently in the population */
+extern long int paco_oldest;        /* position of the oldest solution in paco_population */
+extern double   paco_delta;         /* pheromone that one solution of the population puts on its arcs */
+
+extern long int *active_arcs;       /* arcs i * n + j (i > j) whose pheromone is above trail_min */
+extern long int n_active_arcs;      /* number of arcs in active_arcs */
+extern char     *arc_is_active;     /* state of each arc, see ARC_* */
+extern long int active_arcs_valid;  /* TRUE if active_arcs describes the current pheromone matrix */
+extern long int fused_update;       /* TRUE while deposits are collected for mmas_fused_pheromone_update */
+extern double   active_trail_min;   /* value of trail_min when active_arcs was built */
+
+extern long int *stat_pos;          /* positions of the cities in a tour, for distance_between_ants */
+extern long int *stat_slot;         /* index of a city among the sampled cities, or -1 */
+extern long int *stat_neighbours;   /* the two neighbours of each sampled city in the tour of each ant */
+extern long int *stat_count;        /* frequency of a city among the neighbours of a sampled city */
+extern long int *stat_stamp;        /* stat_count[c] is valid if stat_stamp[c] == stat_epoch */
+extern long int stat_epoch;
 
 /* Pheromone manipulation etc. */
 
 void init_pheromone_trails ( double initial_trail );
 
+void refresh_pheromone_row ( long int i );
+
+void refresh_pheromone_rows ( void );
+
 void evaporation ( void );
 
 void evaporation_nn_list ( void );
@@ -121,6 +167,8 @@ void global_update_pheromone ( ant_struct *a );
 
 void global_update_pheromone_weighted ( ant_struct *a, long int weight );
 
+void compute_heuristic_information( void );
+
 void compute_total_information( void );
 
 void compute_nn_list_total_information( void );
@@ -139,6 +187,10 @@ void choose_closest_next( ant_struct *a, long int phase );
 
 void neighbour_choose_and_move_to_next( ant_struct *a , long int phase );
 
+long int time_bounded_move( ant_struct *a, long int phase );
+
+void complete_tour( ant_struct *a );
+
 /* Auxiliary procedures related to ants */
 
 long int find_best ( void );
@@ -165,14 +217,36 @@ void check_nn_list_pheromone_trail_limits( void );
 
 void check_pheromone_trail_limits( void );
 
+void activate_arc( long int i, long int j );
+
+void allocate_arc_states( void );
+
+void build_active_arcs( void );
+
+void mmas_fused_pheromone_update( void );
+
+void mmas_evaporation_active_arcs( void );
+
+void mmas_update_active_arcs( void );
+
 /* Procedures specific to Ant Colony System */
 
 void global_acs_pheromone_update( ant_struct *a );
 
 void local_acs_pheromone_update( ant_struct *a, long int phase );
 
+void deferred_local_acs_pheromone_update( long int phase );
+
 /* Procedures specific to Best Worst Ant System */
 
 void bwas_worst_ant_update( ant_struct *a1, ant_struct *a2);
 
 void bwas_pheromone_mutation( void );
+
+/* Procedures specific to population-based ACO */
+
+void paco_init_population( void );
+
+void paco_pheromone_update( long int *tour, long int sign );
+
+void paco_population_update( ant_struct *a );
@@ -50,6 +50,8 @@
 
  ***************************************************************************/
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -57,6 +59,10 @@
 #include <math.h>
 #include <limits.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "inout.h"
 #include "thop.h"
 #include "timer.h"
@@ -69,14 +75,17 @@ long int *best_in_try;
 long int *best_found_at;
 double *time_best_found;
 double *time_total_run;
+long int *evaluations_best_found;
 
 long int n_try; /* try counter */
 long int n_tours; /* counter of number constructed tours */
+long int n_evaluations; /* counter of packing plans evaluated by compute_fitness */
 long int iteration; /* iteration counter */
 long int restart_iteration; /* remember iteration when restart was done if any */
 double restart_time; /* remember time when restart was done if any */
 long int max_tries; /* maximum number of independent tries */
 long int max_tours; /* maximum number of tour constructions in one try */
+long int max_evaluations; /* maximum number of packing plan evaluations in one try, 0 = no limit */
 long int max_packing_tries; /* number of tries to construct a good packing plan from a give tour */
 long int seed;
 
@@ -88,12 +97,15 @@ double time_used; /* time used until some given event */
 double time_passed; /* time passed until some moment*/
 long int optimal; /* optimal solution or bound to find */
 
-double mean_ants; /* average tour length */
-double stddev_ants; /* stddev of tour lengths */
+double mean_ants; /* average fitness of the ants */
+double stddev_ants; /* stddev of the fitness of the ants */
+double distance_ants; /* average number of arcs in which the tours of two ants differ */
+double restart_distance; /* If distance_ants < restart_distance * n => update trails */
 double branching_factor; /* average node branching factor when searching */
 double found_branching; /* branching factor when best solution is found */
 
 long int found_best; /* iteration in which best solution is found */
+long int found_evaluations; /* evaluations until the best solution is found */
 long int restart_found_best; /* iteration in which restart-best solution is found */
 
 /* ------------------------------------------------------------------------ */
@@ -106,6 +118,11 @@ int opt;
 long int log_flag; /* --log was given in the command-line.  */
 long int output_flag; 
 long int calibration_mode;
+long int reduce_flag; /* --reduce was given in the command-line.  */
+long int candidate_flag; /* --candidates: kind of candidate lists */
+char candidate_cache_name[LINE_BUF_LEN]; /* --candcache: file of cached candidate lists */
+double checkpoint_period; /* --checkpoint: seconds between two checkpoints */
+long int resume_flag; /* --resume was given in the command-line.  */
 
 void init_program(long int argc, char * argv[])
 /*    
@@ -130,9 +147,10 @@ void init_program(long int argc, char * argv[])
     best_found_at = calloc(max_tries, sizeof(long int));
     time_best_found = calloc(max_tries, sizeof(double));
     time_total_run = calloc(max_tries, sizeof(double));
+    evaluations_best_found = calloc(max_tries, sizeof(long int));
 
     TRACE(printf("read problem data  ..\n\n");)
-    read_thop_instance(input_name_buf, &instance.nodeptr, &instance.itemptr);
+    read_thop_instance(input_name_buf, &instance.nodeptr);
     TRACE(printf("\n .. done\n\n");)
     
     if ( max_time < 0 ) {
@@ -163,6 +181,8 @@ void init_program(long int argc, char * argv[])
     instance.distance = compute_distances();
     
     write_params();
+
+    prune_instance();
     
     allocate_ants();
 }
@@ -179,7 +199,7 @@ void exit_program(void)
         fprintf(log_file,"\n\n");
         long int ntry = 0;
         for(; ntry < max_tries; ntry++) {
-            fprintf(log_file, "try %10ld,        best %10ld,        found at iteration %10ld,        found at time %10.2f\n", ntry, instance.UB + 1 - best_in_try[ntry], best_found_at[ntry], time_best_found[ntry]);
+            fprintf(log_file, "try %10ld,        best %10ld,        found at iteration %10ld,        found at time %10.2f,        found at evaluation %12ld\n", ntry, instance.UB + 1 - best_in_try[ntry], best_found_at[ntry], time_best_found[ntry], evaluations_best_found[ntry]);
             fflush(log_file);
         }
     }
@@ -204,21 +224,27 @@ void init_try( long int ntry )
     TRACE ( printf("INITIALIZE TRIAL\n"); );
 
     start_timers();
-    time_used = elapsed_time( VIRTUAL );
+    set_deadline( max_time );
+    time_used = elapsed_time( budget_timer );
     time_passed = time_used;
 
     /* Initialize variables concerning statistics etc. */
 
     n_tours      = 1;
+    n_evaluations = 0;
     iteration    = 1;
     restart_iteration = 1;
     lambda       = 0.05;
     best_so_far_ant->fitness = INFTY;
+    restart_best_ant->fitness = INFTY;
     found_best   = 0;
+    found_evaluations = 0;
+    ls_calls = ls_improved = ls_gain = 0;
+    ls_time = 0.;
 
     /* Initialize the Pheromone trails, only if ACS is used, pheromones
        have to be initialized differently */
-    if ( !(acs_flag || mmas_flag || bwas_flag) ) {
+    if ( !(acs_flag || mmas_flag || bwas_flag || paco_flag) ) {
         trail_0 = 1. / ( (rho) * nn_tour() );
         /* in the original papers on Ant System, Elitist Ant System, and
            Rank-based Ant System it is not exactly defined what the
@@ -240,6 +266,14 @@ void init_try( long int ntry )
         trail_0 = 1. / ( (double) instance.n * (double) nn_tour( ) ) ;
         init_pheromone_trails( trail_0 );
     }
+    if ( paco_flag ) {
+        /* initial trail and maximum trail 1 as proposed by Guntsch and 
+           Middendorf; each solution of the population contributes an equal share */
+        trail_0 = 1. / ( (double) instance.n - 1. );
+        paco_delta = ( 1. - trail_0 ) / (double) paco_size;
+        init_pheromone_trails( trail_0 );
+        paco_init_population();
+    }
 
     /* Calculate combined information pheromone times heuristic information */
     compute_total_information();
@@ -258,102 +292,786 @@ void exit_try(long int ntry)
     best_in_try[ntry] = best_so_far_ant->fitness;
     best_found_at[ntry] = found_best;
     time_best_found[ntry] = time_used;
-    time_total_run[ntry] = elapsed_time(VIRTUAL);
+    time_total_run[ntry] = elapsed_time(budget_timer);
+    evaluations_best_found[ntry] = found_evaluations;
     
     if (best_so_far_ant->fitness < global_best_ant->fitness) {
         copy_from_to( best_so_far_ant, global_best_ant );
     }
         
+    if (log_file && ls_flag) {
+        fprintf(log_file, "local search: calls %ld,        improved %ld,        gain %ld,        wall-clock time %.2f,        gain per second %.1f\n", 
+                ls_calls, ls_improved, ls_gain, ls_time, ls_time > 0. ? ls_gain / ls_time : 0.);
+    }
     if (log_file) fprintf(log_file,"end try %li \n",ntry);
 }
 
-void read_thop_instance(const char *input_file_name, struct point **nodeptr, struct item **itemptr)
+/* text of an instance file while it is parsed */
+struct instance_text {
+    const char *name;   /* file name, for error messages */
+    const char *p;      /* next character to be parsed */
+    const char *end;    /* end of the text, the text is not NUL-terminated */
+    long int    line;   /* line number of p */
+};
+
+/* keywords of the specification part of a .thop file */
+#define KEY_NAME          0
+#define KEY_DATA_TYPE     1
+#define KEY_DIMENSION     2
+#define KEY_ITEMS         3
+#define KEY_CAPACITY      4
+#define KEY_MAX_TIME      5
+#define KEY_MIN_SPEED     6
+#define KEY_MAX_SPEED     7
+#define KEY_EDGE_WEIGHT   8
+#define KEY_NODE_SECTION  9
+#define KEY_ITEM_SECTION  10
+#define N_KEYS            11
+
+static const char *const instance_keys[N_KEYS] = {
+    "PROBLEM NAME", "KNAPSACK DATA TYPE", "DIMENSION", "NUMBER OF ITEMS",
+    "CAPACITY OF KNAPSACK", "MAX TIME", "MIN SPEED", "MAX SPEED", "EDGE_WEIGHT_TYPE",
+    "NODE_COORD_SECTION", "ITEMS SECTION"
+};
+
+static void instance_error( const struct instance_text *t, const char *message, const char *what )
+/*    
+      FUNCTION: report a malformed instance file and exit
+      INPUT:    parser state, message and the entry the message refers to
+      OUTPUT:   none
+ */
+{
+    fprintf(stderr, "error: %s:%ld: %s%s\n", t->name, t->line, message, what);
+    exit(1);
+}
+
+static int is_blank( char c )
+/*    
+      FUNCTION: check for a blank; '\r' counts as blank, so CRLF line ends are accepted
+      INPUT:    character
+      OUTPUT:   TRUE if c is a blank
+ */
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void skip_blanks( struct instance_text *t )
+/*    
+      FUNCTION: skip blanks within the current line
+      INPUT:    parser state
+      OUTPUT:   none
+ */
+{
+    while ( t->p < t->end && is_blank(*t->p) )
+        t->p++;
+}
+
+static void end_of_line( struct instance_text *t )
+/*    
+      FUNCTION: move to the next line, the rest of the current line has to be blank
+      INPUT:    parser state
+      OUTPUT:   none
+ */
+{
+    skip_blanks(t);
+    if ( t->p < t->end ) {
+        if ( *t->p != '\n' )
+            instance_error(t, "unexpected characters after ", "the last entry of the line");
+        t->p++;
+        t->line++;
+    }
+}
+
+static void skip_line( struct instance_text *t )
+/*    
+      FUNCTION: move to the next line, ignoring the rest of the current line
+      INPUT:    parser state
+      OUTPUT:   none
+ */
+{
+    const char *nl = memchr(t->p, '\n', t->end - t->p);
+
+    t->p = nl != NULL ? nl + 1 : t->end;
+    t->line++;
+}
+
+static void skip_empty_lines( struct instance_text *t )
+/*    
+      FUNCTION: move to the next line that is not empty
+      INPUT:    parser state
+      OUTPUT:   none
+ */
+{
+    const char *q = t->p;
+
+    while ( q < t->end ) {
+        while ( q < t->end && is_blank(*q) )
+            q++;
+        if ( q == t->end || *q != '\n' )
+            break;
+        t->p = ++q;
+        t->line++;
+    }
+}
+
+static void end_of_number( struct instance_text *t, const char *what )
+/*    
+      FUNCTION: check that a number is followed by a blank or the end of the line
+      INPUT:    parser state, name of the entry for error messages
+      OUTPUT:   none
+ */
+{
+    if ( t->p < t->end && !is_blank(*t->p) && *t->p != '\n' )
+        instance_error(t, "malformed number: ", what);
+}
+
+static long int parse_long( struct instance_text *t, const char *what )
+/*    
+      FUNCTION: parse a decimal integer
+      INPUT:    parser state, name of the entry for error messages
+      OUTPUT:   the integer
+ */
+{
+    long int v = 0;
+    int negative = FALSE;
+    const char *start;
+
+    skip_blanks(t);
+    if ( t->p < t->end && ( *t->p == '-' || *t->p == '+' ) )
+        negative = *t->p++ == '-';
+    start = t->p;
+    while ( t->p < t->end && *t->p >= '0' && *t->p <= '9' ) {
+        if ( v > ( LONG_MAX - 9 ) / 10 )
+            instance_error(t, "number too large: ", what);
+        v = 10 * v + ( *t->p++ - '0' );
+    }
+    if ( t->p == start )
+        instance_error(t, "expected an integer: ", what);
+    end_of_number(t, what);
+    return negative ? -v : v;
+}
+
+static double parse_double( struct instance_text *t, const char *what )
+/*    
+      FUNCTION: parse a floating point number
+      INPUT:    parser state, name of the entry for error messages
+      OUTPUT:   the number
+      COMMENTS: numbers with at most 15 digits and no exponent, i.e., all numbers
+                in the instance files, are converted by hand: mantissa and power
+                of ten are exact doubles, so the division is correctly rounded and
+                gives the same result as strtod, which handles all other numbers
+ */
+{
+    static const double power10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                      1e11, 1e12, 1e13, 1e14, 1e15 };
+    const char *start, *q;
+    double mantissa = 0.;
+    int negative = FALSE, digits = 0, fraction = -1;
+    char buf[64], *endptr;
+
+    skip_blanks(t);
+    start = q = t->p;
+    if ( q < t->end && ( *q == '-' || *q == '+' ) )
+        negative = *q++ == '-';
+    for ( ; q < t->end ; q++ ) {
+        if ( *q >= '0' && *q <= '9' ) {
+            mantissa = 10. * mantissa + (double) ( *q - '0' );
+            digits++;
+            if ( fraction >= 0 )
+                fraction++;
+        }
+        else if ( *q == '.' && fraction < 0 )
+            fraction = 0;
+        else
+            break;
+    }
+    if ( digits > 0 && digits <= 15 && ( q == t->end || is_blank(*q) || *q == '\n' ) ) {
+        t->p = q;
+        if ( fraction > 0 )
+            mantissa /= power10[fraction];
+        return negative ? -mantissa : mantissa;
+    }
+    /* exponent, more digits or malformed */
+    for ( q = start ; q < t->end && !is_blank(*q) && *q != '\n' ; q++ )
+        ;
+    if ( q == start || q - start >= (long int) sizeof(buf) )
+        instance_error(t, "expected a number: ", what);
+    memcpy(buf, start, q - start);
+    buf[q - start] = '\0';
+    mantissa = strtod(buf, &endptr);
+    if ( *endptr != '\0' )
+        instance_error(t, "malformed number: ", what);
+    t->p = q;
+    return mantissa;
+}
+
+static void parse_string( struct instance_text *t, char *s, const char *what )
+/*    
+      FUNCTION: copy the rest of the line without surrounding blanks
+      INPUT:    parser state, buffer of LINE_BUF_LEN characters, name of the entry
+      OUTPUT:   none
+ */
+{
+    const char *last;
+
+    skip_blanks(t);
+    for ( last = t->p ; last < t->end && *last != '\n' ; last++ )
+        ;
+    while ( last > t->p && is_blank(last[-1]) )
+        last--;
+    if ( last - t->p >= LINE_BUF_LEN )
+        instance_error(t, "line too long: ", what);
+    memcpy(s, t->p, last - t->p);
+    s[last - t->p] = '\0';
+    t->p = last;
+}
+
+static long int parse_keyword( struct instance_text *t )
+/*    
+      FUNCTION: identify the keyword at the start of a line
+      INPUT:    parser state
+      OUTPUT:   KEY_* of the keyword, N_KEYS for unknown keywords and -1 at the
+                end of the file; t->p is moved behind the keyword and, for the
+                specification part, behind the ':'
+ */
+{
+    long int k;
+    size_t len;
+    const char *colon;
+
+    skip_empty_lines(t);
+    skip_blanks(t);
+    if ( t->p == t->end || ( t->end - t->p >= 3 && memcmp(t->p, "EOF", 3) == 0 ) )
+        return -1;
+    for ( k = 0 ; k < N_KEYS ; k++ ) {
+        len = strlen(instance_keys[k]);
+        if ( (size_t) (t->end - t->p) >= len && memcmp(t->p, instance_keys[k], len) == 0 )
+            break;
+    }
+    if ( k >= KEY_NODE_SECTION ) {   /* sections and unknown keywords */
+        if ( k == N_KEYS ) {
+            colon = t->p;
+            while ( colon < t->end && *colon != ':' && *colon != '\n' )
+                colon++;
+            if ( colon == t->end || *colon != ':' )
+                instance_error(t, "expected a keyword", "");
+        }
+        return k;
+    }
+    t->p += len;
+    skip_blanks(t);
+    if ( t->p == t->end || *t->p != ':' )
+        instance_error(t, "expected ':' after ", instance_keys[k]);
+    t->p++;
+    return k;
+}
+
+static const char *map_instance( const char *name, size_t *size, int *mapped )
+/*    
+      FUNCTION: make the contents of an instance file accessible
+      INPUT:    file name
+      OUTPUT:   pointer to the contents, size is set to their length and mapped
+                to TRUE if the file is mapped into memory
+      COMMENTS: files that cannot be mapped, e.g., pipes, are read into a buffer
+ */
+{
+    int fd;
+    struct stat st;
+    char *text = NULL;
+    size_t capacity = 0;
+    ssize_t r;
+
+    if ( (fd = open(name, O_RDONLY)) < 0 ) {
+        fprintf(stderr, "error: cannot open instance file %s\n", name);
+        exit(1);
+    }
+    *size = 0;
+    *mapped = FALSE;
+    if ( fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 ) {
+        text = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( text != MAP_FAILED ) {
+            *size = (size_t) st.st_size;
+            *mapped = TRUE;
+            close(fd);
+            return text;
+        }
+        text = NULL;
+    }
+    do {
+        if ( *size == capacity ) {
+            capacity = capacity ? 2 * capacity : 1 << 16;
+            if ( (text = realloc(text, capacity)) == NULL )
+                exit(EXIT_FAILURE);
+        }
+        r = read(fd, text + *size, capacity - *size);
+        if ( r > 0 )
+            *size += (size_t) r;
+    } while ( r > 0 );
+    close(fd);
+    if ( r < 0 ) {
+        fprintf(stderr, "error: cannot read instance file %s\n", name);
+        exit(1);
+    }
+    return text;
+}
+
+static int select_distance( const char *edge_weight_type )
+/*    
+      FUNCTION: choose the distance function of an EDGE_WEIGHT_TYPE
+      INPUT:    name of the edge weight type
+      OUTPUT:   TRUE if the type is known
+ */
+{
+    if (strcmp("EUC_2D", edge_weight_type) == 0) distance = round_distance;
+    else if (strcmp("CEIL_2D", edge_weight_type) == 0) distance = ceil_distance;
+    else if (strcmp("GEO", edge_weight_type) == 0) distance = geo_distance;
+    else if (strcmp("ATT", edge_weight_type) == 0) distance = att_distance;
+    else return FALSE;
+    return TRUE;
+}
+
+/* compiled instance files, written by thop-compile */
+#define COMPILED_MAGIC     "THOPBIN1"
+#define COMPILED_VERSION   2
+#define COMPILED_BOM       0x01020304L  /* detects files of another byte order or size of long int */
+#define COMPILED_HEADER    12           /* version, BOM, n, m, capacity, UB, nn, candidates, reduce, size, checksum, prefix */
+#define COMPILED_NAME_LEN  64
+#define COMPILED_ALIGN     64           /* sections start at multiples of a cache line */
+#define COMPILED_SECTIONS  8
+#define COMPILED_HEADER_BYTES ( 8 + COMPILED_HEADER * sizeof(long int) + 3 * sizeof(double) + 2 * COMPILED_NAME_LEN )
+
+static const long int *compiled = NULL;  /* header of the compiled instance, NULL if a .thop file was read */
+static const char *compiled_text;        /* contents of the compiled instance */
+static size_t compiled_offset[COMPILED_SECTIONS + 1];
+
+static size_t compiled_align( size_t bytes )
+{
+    return ( bytes + COMPILED_ALIGN - 1 ) / COMPILED_ALIGN * COMPILED_ALIGN;
+}
+
+static void compiled_layout( long int n, long int m, long int nn, size_t *offset )
+/*    
+      FUNCTION: compute where the sections of a compiled instance start
+      INPUT:    number of cities, of items and of candidates per city, array of
+                COMPILED_SECTIONS + 1 offsets
+      OUTPUT:   none
+      (SIDE)EFFECTS: offset[0..7] are the starts of coordinates, profits, weights,
+                cities and file indices of the items, city_items, distance matrix
+                and candidate lists; offset[8] is the size of the file
+ */
+{
+    size_t bytes[COMPILED_SECTIONS];
+    long int k;
+
+    bytes[0] = (size_t) (n - 1) * sizeof(struct point);  /* the dummy city has no coordinates */
+    bytes[1] = bytes[2] = bytes[3] = bytes[4] = (size_t) m * sizeof(long int);
+    bytes[5] = (size_t) (n + 1) * sizeof(long int);
+    bytes[6] = (size_t) n * (size_t) n * sizeof(long int);
+    bytes[7] = (size_t) n * (size_t) nn * sizeof(long int);
+    offset[0] = compiled_align( COMPILED_HEADER_BYTES );
+    for ( k = 0 ; k < COMPILED_SECTIONS ; k++ )
+        offset[k + 1] = offset[k] + compiled_align( bytes[k] );
+}
+
+unsigned long word_checksum( unsigned long h, const void *p, size_t bytes )
+/*    
+      FUNCTION: continue a checksum, e.g., of a compiled instance, over bytes of p
+      INPUT:    checksum so far, pointer to the data and its number of bytes
+      OUTPUT:   new checksum
+      COMMENTS: the words are copied, since p may point to doubles; bytes after 
+                the last full word are added one by one
+ */
+{
+    unsigned long w;
+    size_t i;
+
+    for ( i = 0 ; i < bytes / sizeof(unsigned long) ; i++ ) {
+        memcpy(&w, (const char *) p + i * sizeof(unsigned long), sizeof(unsigned long));
+        h = ( h ^ w ) * 1000003UL;
+    }
+    for ( i *= sizeof(unsigned long) ; i < bytes ; i++ )
+        h = ( h ^ ((const unsigned char *) p)[i] ) * 1000003UL;
+    return h;
+}
+
+static void compiled_error( const char *name, const char *message )
+{
+    fprintf(stderr, "error: %s: %s\n", name, message);
+    exit(1);
+}
+
+static void load_compiled_instance( const char *name, const char *text, size_t size,
+                                    struct point **nodeptr )
+/*    
+      FUNCTION: take the instance from a file written by thop-compile
+      INPUT:    file name, its contents and their size, pointer to the coordinates
+      OUTPUT:   none
+      (SIDE)EFFECTS: the instance data and the bound UB are set; coordinates and
+                item arrays point into text, which stays mapped until the program
+                ends. Distance matrix and candidate lists are taken from text by
+                compute_distances and compute_nn_lists
+      COMMENTS: the checksum is verified, which reads the whole file once
+ */
+{
+    const long int *h = (const long int *) ( text + 8 );
+    const double *values = (const double *) ( h + COMPILED_HEADER );
+    const char *names = (const char *) ( values + 3 );
+
+    if ( size < compiled_align( COMPILED_HEADER_BYTES )
+         || h[0] != COMPILED_VERSION || h[1] != COMPILED_BOM )
+        compiled_error(name, "compiled by another version or for another machine");
+    if ( h[2] <= 3 || h[2] >= 6000 || h[3] < 0 || h[6] <= 0 || h[6] >= h[2] || h[11] <= 0 || h[11] > h[6] )
+        compiled_error(name, "corrupted header");
+    compiled_layout(h[2], h[3], h[6], compiled_offset);
+    if ( (size_t) h[9] != size || compiled_offset[COMPILED_SECTIONS] != size )
+        compiled_error(name, "truncated file");
+    if ( (long int) word_checksum(0, text + compiled_offset[0], size - compiled_offset[0]) != h[10] )
+        compiled_error(name, "checksum mismatch");
+
+    instance.n = h[2];
+    instance.m = h[3];
+    instance.capacity_of_knapsack = h[4];
+    instance.UB = h[5];
+    instance.max_time = values[0];
+    instance.min_speed = values[1];
+    instance.max_speed = values[2];
+    memcpy(instance.knapsack_data_type, names, COMPILED_NAME_LEN);
+    memcpy(instance.edge_weight_type, names + COMPILED_NAME_LEN, COMPILED_NAME_LEN);
+    instance.knapsack_data_type[COMPILED_NAME_LEN - 1] = instance.edge_weight_type[COMPILED_NAME_LEN - 1] = '\0';
+    if ( !select_distance(instance.edge_weight_type) )
+        compiled_error(name, "unknown EDGE_WEIGHT_TYPE");
+    *nodeptr = (struct point *) ( text + compiled_offset[0] );
+    instance.item_profit = (long int *) ( text + compiled_offset[1] );
+    instance.item_weight = (long int *) ( text + compiled_offset[2] );
+    instance.item_city = (long int *) ( text + compiled_offset[3] );
+    instance.item_id = (long int *) ( text + compiled_offset[4] );
+    instance.city_items = (long int *) ( text + compiled_offset[5] );
+    compiled = h;
+    compiled_text = text;
+}
+
+void read_thop_instance(const char *input_file_name, struct point **nodeptr)
 /*    
       FUNCTION: parse and read instance file
       INPUT:    instance name
       OUTPUT:   list of coordinates for all nodes
-      COMMENTS: Instance files have to be in TSPLIB format, otherwise procedure fails
+      (SIDE)EFFECTS: the item arrays of instance are allocated and filled; items are 
+                grouped by city (CSR layout, see instance.city_items) keeping file order 
+                within a city
+      COMMENTS: the file is mapped into memory and parsed in place. The keywords of 
+                the specification part may appear in any order, but before the section 
+                that needs them. The program exits with the line number if the file is 
+                malformed. Files written by thop-compile are recognised by their first 
+                bytes and loaded by load_compiled_instance
  */
 {
-    FILE *input_file;
+    struct instance_text text;
+    const char *contents;
+    size_t size;
+    int mapped;
     char buf[LINE_BUF_LEN];
-    long int i, j, k;
+    long int i, j, k, key, seen = 0;
+    long int *profit = NULL, *weight = NULL, *city = NULL;
 
-    input_file = fopen(input_file_name, "r");
-    if (input_file == NULL) {
-        fprintf(stderr, "No instance file specified, abort\n");
-        exit(1);
+    contents = map_instance(input_file_name, &size, &mapped);
+    if ( size >= 8 && memcmp(contents, COMPILED_MAGIC, 8) == 0 ) {
+        load_compiled_instance(input_file_name, contents, size, nodeptr);
+        return;
     }
-    assert(input_file != NULL);
+    text.name = input_file_name;
+    text.p = contents;
+    text.end = contents + size;
+    text.line = 1;
     /*printf("\nreading thop-file %s ... \n\n", input_file_name);*/
 
-    fscanf(input_file, "PROBLEM NAME: %s\n", buf);
-    fscanf(input_file, "KNAPSACK DATA TYPE: %[^\n]\n", instance.knapsack_data_type);
-    fscanf(input_file, "DIMENSION: %ld\n", &instance.n); ++instance.n;
-    assert(instance.n > 3 && instance.n < 6000);
-    fscanf(input_file, "NUMBER OF ITEMS: %ld\n", &instance.m);
-    fscanf(input_file, "CAPACITY OF KNAPSACK: %ld\n", &instance.capacity_of_knapsack);
-    fscanf(input_file, "MAX TIME: %lf\n", &instance.max_time);
-    fscanf(input_file, "MIN SPEED: %lf\n", &instance.min_speed);
-    fscanf(input_file, "MAX SPEED: %lf\n", &instance.max_speed);
-    fscanf(input_file, "EDGE_WEIGHT_TYPE: %s\n", buf);
-    if (strcmp("EUC_2D", buf) == 0) distance = round_distance;
-    else if (strcmp("CEIL_2D", buf) == 0) distance = ceil_distance;
-    else if (strcmp("GEO", buf) == 0) distance = geo_distance;
-    else if (strcmp("ATT", buf) == 0) distance = att_distance;
-    fgets(buf, LINE_BUF_LEN, input_file); /* NODE_COORD_SECTION  (INDEX, X, Y): */
-
-    if (( * nodeptr = malloc(sizeof(struct point) * (instance.n))) == NULL)
-        exit(EXIT_FAILURE);
-    else {
-        for (i = 0; i < instance.n - 1; i++) {
-            fscanf(input_file, "%ld %lf %lf\n", & j, &(*nodeptr)[i].x, &(*nodeptr)[i].y);
+    while ( (key = parse_keyword(&text)) >= 0 ) {
+        if ( key < N_KEYS && ( seen & (1L << key) ) )
+            instance_error(&text, "repeated keyword ", instance_keys[key]);
+        switch ( key ) {
+        case KEY_NAME:
+            parse_string(&text, buf, instance_keys[key]);
+            break;
+        case KEY_DATA_TYPE:
+            parse_string(&text, instance.knapsack_data_type, instance_keys[key]);
+            break;
+        case KEY_DIMENSION:
+            instance.n = parse_long(&text, instance_keys[key]) + 1;
+            if ( instance.n <= 3 || instance.n >= 6000 )
+                instance_error(&text, "out of range: ", instance_keys[key]);
+            break;
+        case KEY_ITEMS:
+            instance.m = parse_long(&text, instance_keys[key]);
+            if ( instance.m < 0 )
+                instance_error(&text, "out of range: ", instance_keys[key]);
+            break;
+        case KEY_CAPACITY:
+            instance.capacity_of_knapsack = parse_long(&text, instance_keys[key]);
+            break;
+        case KEY_MAX_TIME:
+            instance.max_time = parse_double(&text, instance_keys[key]);
+            break;
+        case KEY_MIN_SPEED:
+            instance.min_speed = parse_double(&text, instance_keys[key]);
+            break;
+        case KEY_MAX_SPEED:
+            instance.max_speed = parse_double(&text, instance_keys[key]);
+            break;
+        case KEY_EDGE_WEIGHT:
+            parse_string(&text, instance.edge_weight_type, instance_keys[key]);
+            if ( !select_distance(instance.edge_weight_type) )
+                instance_error(&text, "unknown EDGE_WEIGHT_TYPE ", instance.edge_weight_type);
+            break;
+        case KEY_NODE_SECTION:  /* NODE_COORD_SECTION  (INDEX, X, Y): */
+            if ( !( seen & (1L << KEY_DIMENSION) ) )
+                instance_error(&text, "DIMENSION has to precede ", instance_keys[key]);
+            skip_line(&text);
+            if (( * nodeptr = malloc(sizeof(struct point) * (instance.n))) == NULL)
+                exit(EXIT_FAILURE);
+            for (i = 0; i < instance.n - 1; i++) {
+                skip_empty_lines(&text);
+                parse_long(&text, "node index");
+                (*nodeptr)[i].x = parse_double(&text, "x coordinate");
+                (*nodeptr)[i].y = parse_double(&text, "y coordinate");
+                end_of_line(&text);
+            }
+            TRACE(printf("number of cities is %ld\n", n);)
+            break;
+        case KEY_ITEM_SECTION:  /* ITEMS SECTION    (INDEX, PROFIT, WEIGHT, ASSIGNED NODE NUMBER): */
+            if ( !( seen & (1L << KEY_ITEMS) ) || !( seen & (1L << KEY_NODE_SECTION) ) )
+                instance_error(&text, "NUMBER OF ITEMS and NODE_COORD_SECTION have to precede ", instance_keys[key]);
+            skip_line(&text);
+            profit = malloc(instance.m * sizeof(long int));
+            weight = malloc(instance.m * sizeof(long int));
+            city = malloc(instance.m * sizeof(long int));
+            instance.item_profit = malloc(instance.m * sizeof(long int));
+            instance.item_weight = malloc(instance.m * sizeof(long int));
+            instance.item_city = malloc(instance.m * sizeof(long int));
+            instance.item_id = malloc(instance.m * sizeof(long int));
+            instance.city_items = calloc(instance.n + 1, sizeof(long int));
+            if ( profit == NULL || weight == NULL || city == NULL || instance.item_profit == NULL || 
+                 instance.item_weight == NULL || instance.item_city == NULL || instance.item_id == NULL || 
+                 instance.city_items == NULL )
+                exit(EXIT_FAILURE);
+            for (i = 0; i < instance.m; i++) {
+                skip_empty_lines(&text);
+                parse_long(&text, "item index");
+                profit[i] = parse_long(&text, "profit");
+                weight[i] = parse_long(&text, "weight");
+                city[i] = parse_long(&text, "assigned node number") - 1;
+                if ( profit[i] < 0 || weight[i] <= 0 )
+                    instance_error(&text, "out of range: ", profit[i] < 0 ? "profit" : "weight");
+                if ( city[i] < 0 || city[i] >= instance.n - 1 )
+                    instance_error(&text, "out of range: ", "assigned node number");
+                instance.city_items[city[i] + 1]++;
+                end_of_line(&text);
+            }
+            break;
+        default:                /* other keywords, e.g., COMMENT, are ignored */
+            skip_line(&text);
+            break;
         }
+        if ( key < N_KEYS )
+            seen |= 1L << key;
+        if ( key < KEY_NODE_SECTION )
+            end_of_line(&text);
     }
-    TRACE(printf("number of cities is %ld\n", n);)
-
-    fgets(buf, LINE_BUF_LEN, input_file); /* ITEMS SECTION    (INDEX, PROFIT, WEIGHT, ASSIGNED NODE NUMBER): */
-
-    if (( * itemptr = malloc(sizeof(struct item) * instance.m)) == NULL)
-        exit(EXIT_FAILURE);
-    else {
-        for (i = 0; i < instance.m; i++) {
-            fscanf(input_file, "%ld %ld %ld %ld\n", &j, &(*itemptr)[i].profit, &(*itemptr)[i].weight, &(*itemptr)[i].id_city);
-            (*itemptr)[i].id_city -= 1;
-        }
+    for ( k = 0 ; k < N_KEYS ; k++ ) {
+        if ( k != KEY_NAME && k != KEY_DATA_TYPE && !( seen & (1L << k) ) )
+            instance_error(&text, "missing ", instance_keys[k]);
     }
+    if ( mapped )
+        munmap((void *) contents, size);
+    else
+        free((void *) contents);
+
+    /* counting sort of the items by city */
+    for (i = 0; i < instance.n; i++) {
+        instance.city_items[i + 1] += instance.city_items[i];
+    }
+    for (i = 0; i < instance.m; i++) {
+        k = instance.city_items[city[i]]++;
+        instance.item_profit[k] = profit[i];
+        instance.item_weight[k] = weight[i];
+        instance.item_city[k] = city[i];
+        instance.item_id[k] = i;
+    }
+    for (i = instance.n; i > 0; i--) {
+        instance.city_items[i] = instance.city_items[i - 1];
+    }
+    instance.city_items[0] = 0;
+    free(profit);
+    free(weight);
+    free(city);
     
-    double *item_vector = malloc(instance.m * sizeof(double));
-    long int *help_vector = malloc(instance.m * sizeof(long int));
+    sort_pair_double *item_vector = malloc(instance.m * sizeof(sort_pair_double));
     
     for ( j = 0 ; j < instance.m ; j++ ) {
-        item_vector[j] = ( -1.0 * (*itemptr)[j].profit ) / (*itemptr)[j].weight;
-        help_vector[j] = j;
+        item_vector[j].key = ( -1.0 * instance.item_profit[j] ) / instance.item_weight[j];
+        item_vector[j].index = j;
     }
 
-    sort2_double(item_vector, help_vector, 0, instance.m - 1);
+    sort_pairs_double(item_vector, instance.m);
     
     instance.UB = 0;
     long int _w = 0;
     for ( k = 0 ; k < instance.m ; k++ ) {
-        j = help_vector[k];
-        if ( _w + (*itemptr)[j].weight <= instance.capacity_of_knapsack ) {
-            _w += (*itemptr)[j].weight;
-            instance.UB += (*itemptr)[j].profit;
+        j = item_vector[k].index;
+        if ( _w + instance.item_weight[j] <= instance.capacity_of_knapsack ) {
+            _w += instance.item_weight[j];
+            instance.UB += instance.item_profit[j];
         }
         else {
-            instance.UB += ceil((instance.capacity_of_knapsack - _w) / (double) (*itemptr)[j].weight * (*itemptr)[j].profit);
+            instance.UB += ceil((instance.capacity_of_knapsack - _w) / (double) instance.item_weight[j] * instance.item_profit[j]);
             break;
         }
     }
     
     free(item_vector);
-    free(help_vector);
 
     TRACE(printf("number of items is %ld\n", instance.m);)
     TRACE(printf("\n... done\n");)
-    
-    fclose(input_file);
+}
+
+long int **compiled_distances( void )
+/*    
+      FUNCTION: distance matrix of a compiled instance
+      INPUT:    none
+      OUTPUT:   the matrix, NULL if the instance was read from a .thop file
+      COMMENTS: only the row pointers are allocated, the rows are those of the
+                compiled file; the matrix is freed like one of compute_distances
+ */
+{
+    long int i, **matrix;
+
+    if ( compiled == NULL )
+        return NULL;
+    if ( (matrix = malloc(instance.n * sizeof(long int *))) == NULL )
+        exit(EXIT_FAILURE);
+    for ( i = 0 ; i < instance.n ; i++ )
+        matrix[i] = (long int *) ( compiled_text + compiled_offset[6] ) + i * instance.n;
+    return matrix;
+}
+
+long int **compiled_nn_lists( long int nn, long int prefix )
+/*    
+      FUNCTION: candidate lists of a compiled instance
+      INPUT:    length nn of the lists and length prefix of their part for the
+                tour construction, see compute_nn_lists
+      OUTPUT:   the lists, NULL if the instance was read from a .thop file or
+                was compiled with other --candidates or --reduce settings or
+                shorter lists
+      COMMENTS: a list of nearest neighbours starts with the shorter lists, so
+                longer compiled lists are used as well; quadrant and alpha-nearness
+                lists have to be of length nn and have the same prefix. As for 
+                compiled_distances only the row pointers are allocated
+ */
+{
+    long int i, **m_nnear;
+
+    if ( compiled == NULL || compiled[7] != candidate_flag || compiled[8] != reduce_flag
+         || nn > compiled[6] 
+         || ( candidate_flag != CAND_NEAREST && ( nn < compiled[6] || prefix != compiled[11] ) ) )
+        return NULL;
+    if ( (m_nnear = malloc(instance.n * sizeof(long int *))) == NULL )
+        exit(EXIT_FAILURE);
+    for ( i = 0 ; i < instance.n ; i++ )
+        m_nnear[i] = (long int *) ( compiled_text + compiled_offset[7] ) + i * compiled[6];
+    return m_nnear;
+}
+
+static void compiled_write( const void *p, size_t bytes, FILE *f, unsigned long *h )
+{
+    fwrite(p, 1, bytes, f);
+    *h = word_checksum(*h, p, bytes);
+}
+
+static void compiled_pad( size_t bytes, FILE *f, unsigned long *h )
+/*    
+      FUNCTION: write zeros up to the end of a section of the compiled instance
+      INPUT:    size of the section, file and checksum so far
+      OUTPUT:   none
+ */
+{
+    static const unsigned long zero[COMPILED_ALIGN / sizeof(unsigned long)];
+
+    compiled_write(zero, compiled_align(bytes) - bytes, f, h);
+}
+
+void write_compiled_instance( const char *file_name )
+/*    
+      FUNCTION: save the instance with distance matrix, candidate lists and the
+                bound UB in binary form, see thop_compile.c
+      INPUT:    name of the compiled file
+      OUTPUT:   none
+      COMMENTS: the candidate lists are those of the current --candidates, --nnants,
+                --nnls and --reduce settings. Sections are aligned to COMPILED_ALIGN
+                bytes, so that they can be used directly from the mapped file. The
+                format is binary and specific to the machine, like checkpoints
+ */
+{
+    FILE *f;
+    long int i, header[COMPILED_HEADER];
+    const long int nn = candidate_list_length();
+    double values[3];
+    char names[2 * COMPILED_NAME_LEN];
+    size_t offset[COMPILED_SECTIONS + 1];
+    unsigned long h = 0, unused = 0;
+
+    if ( strlen(instance.knapsack_data_type) >= COMPILED_NAME_LEN
+         || strlen(instance.edge_weight_type) >= COMPILED_NAME_LEN )
+        compiled_error(file_name, "KNAPSACK DATA TYPE or EDGE_WEIGHT_TYPE is too long");
+    if ( (f = fopen(file_name, "wb")) == NULL )
+        compiled_error(file_name, "cannot create file");
+    compiled_layout(instance.n, instance.m, nn, offset);
+    header[0] = COMPILED_VERSION;
+    header[1] = COMPILED_BOM;
+    header[2] = instance.n;
+    header[3] = instance.m;
+    header[4] = instance.capacity_of_knapsack;
+    header[5] = instance.UB;
+    header[6] = nn;
+    header[7] = candidate_flag;
+    header[8] = reduce_flag;
+    header[9] = (long int) offset[COMPILED_SECTIONS];
+    header[10] = 0;  /* checksum, written at the end */
+    header[11] = candidate_prefix_length();
+    values[0] = instance.max_time;
+    values[1] = instance.min_speed;
+    values[2] = instance.max_speed;
+    memset(names, 0, sizeof(names));
+    memcpy(names, instance.knapsack_data_type, strlen(instance.knapsack_data_type));
+    memcpy(names + COMPILED_NAME_LEN, instance.edge_weight_type, strlen(instance.edge_weight_type));
+
+    fwrite(COMPILED_MAGIC, 1, 8, f);
+    fwrite(header, sizeof(long int), COMPILED_HEADER, f);
+    fwrite(values, sizeof(double), 3, f);
+    fwrite(names, 1, sizeof(names), f);
+    compiled_pad(COMPILED_HEADER_BYTES, f, &unused);
+
+    compiled_write(instance.nodeptr, (instance.n - 1) * sizeof(struct point), f, &h);
+    compiled_pad((instance.n - 1) * sizeof(struct point), f, &h);
+    compiled_write(instance.item_profit, instance.m * sizeof(long int), f, &h);
+    compiled_pad(instance.m * sizeof(long int), f, &h);
+    compiled_write(instance.item_weight, instance.m * sizeof(long int), f, &h);
+    compiled_pad(instance.m * sizeof(long int), f, &h);
+    compiled_write(instance.item_city, instance.m * sizeof(long int), f, &h);
+    compiled_pad(instance.m * sizeof(long int), f, &h);
+    compiled_write(instance.item_id, instance.m * sizeof(long int), f, &h);
+    compiled_pad(instance.m * sizeof(long int), f, &h);
+    compiled_write(instance.city_items, (instance.n + 1) * sizeof(long int), f, &h);
+    compiled_pad((instance.n + 1) * sizeof(long int), f, &h);
+    for ( i = 0 ; i < instance.n ; i++ )
+        compiled_write(instance.distance[i], instance.n * sizeof(long int), f, &h);
+    compiled_pad(instance.n * instance.n * sizeof(long int), f, &h);
+    for ( i = 0 ; i < instance.n ; i++ )
+        compiled_write(instance.nn_list[i], nn * sizeof(long int), f, &h);
+    compiled_pad(instance.n * nn * sizeof(long int), f, &h);
+
+    header[10] = (long int) h;
+    fseek(f, 8, SEEK_SET);
+    fwrite(header, sizeof(long int), COMPILED_HEADER, f);
+    if ( ferror(f) || fclose(f) != 0 )
+        compiled_error(file_name, "cannot write file");
 }
 
 void set_default_parameters(void)
@@ -375,11 +1093,13 @@ void set_default_parameters(void)
     q_0 = 0.0;
     max_tries = 1;
     max_tours = 0;
+    max_evaluations = 0;
     max_packing_tries = 1;
     seed = (long int) time(NULL);
     max_time = -1;
     optimal = 1;
     branch_fac = 1.00001;
+    restart_distance = 0.;
     u_gb = INFTY;
     as_flag = FALSE;
     eas_flag = FALSE;
@@ -387,8 +1107,17 @@ void set_default_parameters(void)
     mmas_flag = TRUE;
     bwas_flag = FALSE;
     acs_flag = FALSE;
+    acs_deferred_flag = FALSE;
+    paco_flag = FALSE;
+    paco_size = 5;
     ras_ranks = 0;
     elitist_ants = 0;
+    reduce_flag = FALSE;
+    partial_flag = FALSE;
+    candidate_flag = CAND_NEAREST;
+    candidate_cache_name[0] = '\0';
+    checkpoint_period = 0.;
+    resume_flag = FALSE;
 }
 
 void set_default_as_parameters(void) {
@@ -463,6 +1192,18 @@ void set_default_acs_parameters(void) {
     elitist_ants = 0;
 }
 
+void set_default_paco_parameters(void) {
+    assert(paco_flag);
+    n_ants = 10; /* number of ants */
+    nn_ants = 20; /* number of nearest neighbours in tour construction */
+    alpha = 1.0;
+    beta = 2.0;
+    rho = 0.0; /* not used, there is no evaporation in PACO */
+    q_0 = 0.0;
+    ras_ranks = 0;
+    elitist_ants = 0;
+}
+
 void set_default_ls_parameters(void) {
     assert(ls_flag);
     dlb_flag = TRUE; /* apply don't look bits in local search */
@@ -492,16 +1233,18 @@ void save_best_thop_solution(void)
 {
     int i, first_print;
     char *visited = calloc(instance.n, sizeof(char));
+    char *picked = calloc(instance.m, sizeof(char));  /* indexed by the item number in the file */
     visited[0] = visited[instance.n - 2] = 1;
 
     long int profit = 0.0;
 
     for (i = 0; i < instance.m; i++) {
-        if ( global_best_ant->packing_plan[i] ) {
-            visited[instance.itemptr[i].id_city] = 1;
-            profit += instance.itemptr[i].profit;
+        if ( BITSET_TEST(global_best_ant->packing_plan, i) ) {
+            visited[instance.item_city[i]] = 1;
+            picked[instance.item_id[i]] = 1;
         }
     }
+    profit = packing_plan_profit(global_best_ant->packing_plan);
     
     FILE *sol_file = fopen(output_name_buf, "w");
     
@@ -520,7 +1263,7 @@ void save_best_thop_solution(void)
 
     first_print = TRUE;
     for (i = 0; i < instance.m; i++) {
-        if ( global_best_ant->packing_plan[i] ) {
+        if ( picked[i] ) {
             if ( first_print == TRUE ) {
                 first_print = FALSE;            
                 fprintf(sol_file, "%d", i+1);
@@ -530,10 +1273,270 @@ void save_best_thop_solution(void)
     }
     fprintf(sol_file, "]\n");
     free(visited);
+    free(picked);
     
     fclose(sol_file);
 }
 
+#define CHECKPOINT_MAGIC "THOPCKP2"
+
+static long int checkpoint_io_ok;  /* FALSE once a read or write of a checkpoint failed */
+static unsigned long params_checksum;  /* checksum of the parameters, set by write_params */
+
+static void checkpoint_io( void *p, size_t size, size_t k, FILE *f, long int write )
+/*    
+      FUNCTION: write k objects of the given size to f, or read them from f
+      INPUT:    pointer to the objects, their size and number, the file and 
+                the direction
+      OUTPUT:   none
+      (SIDE)EFFECTS: checkpoint_io_ok is reset if not all objects are transferred
+ */
+{
+    if ( k == 0 )
+        return;
+    if ( ( write ? fwrite(p, size, k, f) : fread(p, size, k, f) ) != k )
+        checkpoint_io_ok = FALSE;
+}
+
+static void checkpoint_ant( ant_struct *a, FILE *f, long int write )
+/*    
+      FUNCTION: write ant a to a checkpoint file, or read it
+      INPUT:    pointer to the ant, the file and the direction
+      OUTPUT:   none
+ */
+{
+    checkpoint_io( a->tour, sizeof(long int), instance.n + 1, f, write );
+    checkpoint_io( a->packing_plan, sizeof(unsigned long int), BITSET_WORDS(instance.m), f, write );
+    checkpoint_io( a->visited, sizeof(char), instance.n, f, write );
+    checkpoint_io( &a->fitness, sizeof(long int), 1, f, write );
+    checkpoint_io( &a->n_constructed, sizeof(long int), 1, f, write );
+    checkpoint_io( &a->time_max_speed, sizeof(double), 1, f, write );
+}
+
+static void checkpoint_state( FILE *f, long int write )
+/*    
+      FUNCTION: write the state of the run after the header of a checkpoint, 
+                or read it
+      INPUT:    the file and the direction
+      OUTPUT:   none
+      COMMENTS: the state of a try is taken at the end of an iteration; the 
+                ants of the colony are rebuilt in each iteration and are not part 
+                of it. The total information is saved as well, since with local 
+                search it is only updated on the arcs of the candidate lists
+ */
+{
+    long int i;
+    long int counters[15];
+    double   values[10];
+
+    if ( write ) {
+        counters[0] = n_try;              counters[1] = iteration;
+        counters[2] = n_tours;            counters[3] = n_evaluations;
+        counters[4] = restart_iteration;  counters[5] = found_best;
+        counters[6] = restart_found_best; counters[7] = found_evaluations;
+        counters[8] = seed;               counters[9] = paco_n;
+        counters[10] = paco_oldest;       counters[11] = ls_calls;
+        counters[12] = ls_improved;       counters[13] = ls_gain;
+        counters[14] = u_gb;
+        values[0] = elapsed_time( budget_timer ); values[1] = time_used;
+        values[2] = restart_time;         values[3] = trail_max;
+        values[4] = trail_min;            values[5] = trail_0;
+        values[6] = epoch_trail;          values[7] = branching_factor;
+        values[8] = found_branching;      values[9] = ls_time;
+    }
+    checkpoint_io( counters, sizeof(long int), 15, f, write );
+    checkpoint_io( values, sizeof(double), 10, f, write );
+    checkpoint_io( best_in_try, sizeof(long int), max_tries, f, write );
+    checkpoint_io( best_found_at, sizeof(long int), max_tries, f, write );
+    checkpoint_io( time_best_found, sizeof(double), max_tries, f, write );
+    checkpoint_io( time_total_run, sizeof(double), max_tries, f, write );
+    checkpoint_io( evaluations_best_found, sizeof(long int), max_tries, f, write );
+    checkpoint_ant( best_so_far_ant, f, write );
+    checkpoint_ant( restart_best_ant, f, write );
+    checkpoint_ant( global_best_ant, f, write );
+    for ( i = 0 ; i < instance.n ; i++ ) {
+        checkpoint_io( pheromone[i], sizeof(double), instance.n, f, write );
+        checkpoint_io( total[i], sizeof(double), instance.n, f, write );
+    }
+    if ( paco_flag ) {
+        for ( i = 0 ; i < paco_size ; i++ )
+            checkpoint_io( paco_population[i], sizeof(long int), instance.n + 1, f, write );
+    }
+
+    if ( !write && checkpoint_io_ok ) {
+        n_try = counters[0];              iteration = counters[1];
+        n_tours = counters[2];            n_evaluations = counters[3];
+        restart_iteration = counters[4];  found_best = counters[5];
+        restart_found_best = counters[6]; found_evaluations = counters[7];
+        seed = counters[8];               paco_n = counters[9];
+        paco_oldest = counters[10];       ls_calls = counters[11];
+        ls_improved = counters[12];       ls_gain = counters[13];
+        u_gb = counters[14];
+        resume_timers( values[0] );       time_used = values[1];
+        restart_time = values[2];         trail_max = values[3];
+        trail_min = values[4];            trail_0 = values[5];
+        epoch_trail = values[6];          branching_factor = values[7];
+        found_branching = values[8];      ls_time = values[9];
+    }
+}
+
+static unsigned long instance_checksum( void )
+/*    
+      FUNCTION: checksum of the data of the instance
+      INPUT:    none
+      OUTPUT:   checksum of capacity, time limit, speeds, items and coordinates
+ */
+{
+    unsigned long h;
+    double values[3];
+
+    values[0] = instance.max_time;
+    values[1] = instance.min_speed;
+    values[2] = instance.max_speed;
+    h = word_checksum(0, &instance.capacity_of_knapsack, sizeof(long int));
+    h = word_checksum(h, values, sizeof(values));
+    h = word_checksum(h, instance.item_profit, instance.m * sizeof(long int));
+    h = word_checksum(h, instance.item_weight, instance.m * sizeof(long int));
+    h = word_checksum(h, instance.item_city, instance.m * sizeof(long int));
+    h = word_checksum(h, instance.item_id, instance.m * sizeof(long int));
+    return word_checksum(h, instance.nodeptr, (instance.n - 1) * sizeof(struct point));
+}
+
+static void checkpoint_header( long int *h )
+/*    
+      FUNCTION: describe the instance and the parameters a checkpoint belongs to
+      INPUT:    array of CHECKPOINT_HEADER entries
+      OUTPUT:   none
+ */
+{
+    h[0] = instance.n;
+    h[1] = instance.m;
+    h[2] = n_ants;
+    h[3] = max_tries;
+    h[4] = as_flag | eas_flag << 1 | ras_flag << 2 | mmas_flag << 3 | bwas_flag << 4 
+        | acs_flag << 5 | paco_flag << 6;
+    h[5] = paco_size;
+    h[6] = ls_flag;
+    h[7] = BITSET_WORDS(instance.m);
+    h[8] = (long int) instance_checksum();
+    h[9] = (long int) params_checksum;
+}
+
+void write_checkpoint( void )
+/*    
+      FUNCTION: save the state of the current try to <outputfile>.ckpt
+      INPUT:    none
+      OUTPUT:   none
+      COMMENTS: the file is written to <outputfile>.ckpt.tmp and then renamed, 
+                so that an interrupted write leaves the previous checkpoint 
+                intact. The format is binary and specific to the machine
+ */
+{
+    FILE *f;
+    long int header[CHECKPOINT_HEADER];
+    char name[LINE_BUF_LEN + 16], tmp_name[LINE_BUF_LEN + 16];
+
+    if ( !output_flag )
+        return;
+    sprintf(name, "%s.ckpt", output_name_buf);
+    sprintf(tmp_name, "%s.ckpt.tmp", output_name_buf);
+    if ( (f = fopen(tmp_name, "wb")) == NULL ) {
+        fprintf(stderr, "cannot write checkpoint %s\n", tmp_name);
+        return;
+    }
+    refresh_pheromone_rows();
+    checkpoint_header( header );
+    checkpoint_io_ok = TRUE;
+    checkpoint_io( CHECKPOINT_MAGIC, 1, 8, f, TRUE );
+    checkpoint_io( header, sizeof(long int), CHECKPOINT_HEADER, f, TRUE );
+    checkpoint_state( f, TRUE );
+    if ( fclose(f) != 0 || !checkpoint_io_ok || rename(tmp_name, name) != 0 ) {
+        fprintf(stderr, "cannot write checkpoint %s\n", name);
+        return;
+    }
+    if (log_file) {
+        fprintf(log_file, "checkpoint iteration %10ld,        time %10.2f\n", iteration, elapsed_time(budget_timer));
+        fflush(log_file);
+    }
+}
+
+long int checkpoint_try( void )
+/*    
+      FUNCTION: find the try saved in <outputfile>.ckpt
+      INPUT:    none
+      OUTPUT:   number of the saved try, -1 if there is no checkpoint
+      COMMENTS: the program exits if the checkpoint belongs to another 
+                instance or to other parameters
+ */
+{
+    FILE *f;
+    char magic[8];
+    long int header[CHECKPOINT_HEADER], expected[CHECKPOINT_HEADER], ntry;
+    char name[LINE_BUF_LEN + 16];
+
+    sprintf(name, "%s.ckpt", output_name_buf);
+    if ( (f = fopen(name, "rb")) == NULL )
+        return -1;
+    checkpoint_header( expected );
+    checkpoint_io_ok = TRUE;
+    checkpoint_io( magic, 1, 8, f, FALSE );
+    checkpoint_io( header, sizeof(long int), CHECKPOINT_HEADER, f, FALSE );
+    checkpoint_io( &ntry, sizeof(long int), 1, f, FALSE );
+    fclose(f);
+    if ( !checkpoint_io_ok || memcmp(magic, CHECKPOINT_MAGIC, 8) != 0 ) {
+        fprintf(stderr, "checkpoint %s is not a checkpoint of this version\n", name);
+        exit(1);
+    }
+    if ( header[0] != expected[0] || header[1] != expected[1] || header[8] != expected[8] ) {
+        fprintf(stderr, "checkpoint %s belongs to another instance\n", name);
+        exit(1);
+    }
+    if ( memcmp(header, expected, sizeof(header)) != 0 ) {
+        fprintf(stderr, "checkpoint %s was written with other parameters\n", name);
+        exit(1);
+    }
+    return ntry;
+}
+
+void read_checkpoint( void )
+/*    
+      FUNCTION: restore the state of a try from <outputfile>.ckpt
+      INPUT:    none
+      OUTPUT:   none
+      (SIDE)EFFECTS: the try continues where the checkpoint was taken
+      COMMENTS: called after init_try of the try returned by checkpoint_try
+ */
+{
+    FILE *f;
+    char magic[8];
+    long int i, header[CHECKPOINT_HEADER];
+    char name[LINE_BUF_LEN + 16];
+
+    sprintf(name, "%s.ckpt", output_name_buf);
+    if ( (f = fopen(name, "rb")) == NULL ) {
+        fprintf(stderr, "cannot read checkpoint %s\n", name);
+        exit(1);
+    }
+    checkpoint_io_ok = TRUE;
+    checkpoint_io( magic, 1, 8, f, FALSE );
+    checkpoint_io( header, sizeof(long int), CHECKPOINT_HEADER, f, FALSE );
+    checkpoint_state( f, FALSE );
+    fclose(f);
+    if ( !checkpoint_io_ok ) {
+        fprintf(stderr, "cannot read checkpoint %s\n", name);
+        exit(1);
+    }
+    /* the pheromones were saved with all rows valid */
+    for ( i = 0 ; i < instance.n ; i++ )
+        row_epoch[i] = pheromone_epoch;
+    active_arcs_valid = FALSE;
+    set_deadline( max_time );
+    if (log_file) {
+        fprintf(log_file, "resumed iteration %10ld,        time %10.2f\n", iteration, elapsed_time(budget_timer));
+        fflush(log_file);
+    }
+}
+
 void write_report(void)
 /*    
       FUNCTION: output some info about trial (best-so-far solution quality, time)
@@ -543,45 +1546,105 @@ void write_report(void)
  */
 {
     if (log_file) {
-        fprintf(log_file, "best %10ld,        iteration: %10ld,        time %10.2f\n", instance.UB + 1 - best_so_far_ant->fitness, iteration, elapsed_time(VIRTUAL));
+        fprintf(log_file, "best %10ld,        iteration: %10ld,        time %10.2f,        evaluations %12ld\n", instance.UB + 1 - best_so_far_ant->fitness, iteration, elapsed_time(budget_timer), n_evaluations);
         fflush(log_file);
     }
 }
 
 
+static void print_params( FILE *f )
+/*    
+      FUNCTION:       writes chosen parameter settings to a file
+      INPUT:          the file
+      OUTPUT:         none
+ */
+{
+    fprintf(f, "Parameter-settings: \n\n");
+    fprintf(f, "--inputfile          %s\n", input_name_buf);
+    fprintf(f, "--outputfile         %s\n", output_name_buf);
+    fprintf(f, "--tries              %ld\n", max_tries);
+    fprintf(f, "--tours              %ld\n", max_tours);
+    fprintf(f, "--evaluations        %ld\n", max_evaluations);
+    fprintf(f, "--ptries             %ld\n", max_packing_tries);    
+    fprintf(f, "--time               %.2f\n", max_time);
+    fprintf(f, "--clock              %d\n", budget_timer == REAL ? 1 : ( budget_timer == THREAD ? 2 : 0 ));
+    fprintf(f, "--seed               %ld\n", seed);
+    fprintf(f, "--optimum            %ld\n", optimal);
+    fprintf(f, "--ants               %ld\n", n_ants);
+    fprintf(f, "--nnants             %ld\n", nn_ants);
+    fprintf(f, "--alpha              %.2f\n", alpha);
+    fprintf(f, "--beta               %.2f\n", beta);
+    fprintf(f, "--rho                %.2f\n", rho);
+    fprintf(f, "--q0                 %.2f\n", q_0);
+    fprintf(f, "--elitistants        %ld\n", elitist_ants);
+    fprintf(f, "--rasranks           %ld\n", ras_ranks);
+    fprintf(f, "--localsearch        %ld\n", ls_flag);
+    fprintf(f, "--nnls               %ld\n", nn_ls);
+    fprintf(f, "--dlb                %ld\n", dlb_flag);
+    fprintf(f, "--lspolicy           %ld\n", ls_policy);
+    fprintf(f, "--lsants             %ld\n", ls_ants);
+    fprintf(f, "--lsbudget           %.2f\n", ls_budget);
+    fprintf(f, "--candidates         %ld\n", candidate_flag);
+    fprintf(f, "--candcache          %s\n", candidate_cache_name);
+    fprintf(f, "--restartdist        %.3f\n", restart_distance);
+    fprintf(f, "--as                 %ld\n", as_flag);
+    fprintf(f, "--eas                %ld\n", eas_flag);
+    fprintf(f, "--ras                %ld\n", ras_flag);
+    fprintf(f, "--mmas               %ld\n", mmas_flag);
+    fprintf(f, "--bwas               %ld\n", bwas_flag);
+    fprintf(f, "--acs                %ld\n", acs_flag);
+    fprintf(f, "--deferred           %ld\n", acs_deferred_flag);
+    fprintf(f, "--paco               %ld\n", paco_flag);
+    fprintf(f, "--popsize            %ld\n", paco_size);
+    fprintf(f, "--reduce             %ld\n", reduce_flag);
+    fprintf(f, "--checkpoint         %.2f\n", checkpoint_period);
+    fprintf(f, "--resume             %ld\n", resume_flag);
+    fprintf(f, "--partial            %ld\n\n", partial_flag);
+}
+
+static unsigned long parameter_checksum( void )
+/*    
+      FUNCTION:       checksum of the parameter settings as written by write_params
+      INPUT:          none
+      OUTPUT:         the checksum
+      COMMENTS:       --inputfile, --candcache, --checkpoint and --resume are left 
+                      out, since they do not change the search and a resumed run may 
+                      read the compiled instance, change the period and has to set 
+                      --resume
+ */
+{
+    FILE *f;
+    char line[LINE_BUF_LEN + 32];
+    unsigned long h = 0;
+    size_t i;
+
+    if ( (f = tmpfile()) == NULL ) {
+        fprintf(stderr, "cannot create a temporary file\n");
+        exit(1);
+    }
+    print_params(f);
+    rewind(f);
+    while ( fgets(line, sizeof(line), f) != NULL ) {
+        if ( strncmp(line, "--inputfile ", 12) == 0 || strncmp(line, "--candcache ", 12) == 0
+             || strncmp(line, "--checkpoint ", 13) == 0 || strncmp(line, "--resume ", 9) == 0 )
+            continue;
+        for ( i = 0 ; line[i] != '\0' ; i++ )
+            h = ( h ^ (unsigned char) line[i] ) * 1000003UL;
+    }
+    fclose(f);
+    return h;
+}
+
 void write_params(void)
 /*    
       FUNCTION:       writes chosen parameter settings in log file 
       INPUT:          none
       OUTPUT:         none
+      (SIDE)EFFECTS:  the parameters are remembered for checking checkpoints
  */
 {
-    if (log_file) {           
-        fprintf(log_file, "Parameter-settings: \n\n");
-        fprintf(log_file, "--inputfile          %s\n", input_name_buf);
-        fprintf(log_file, "--outputfile         %s\n", output_name_buf);
-        fprintf(log_file, "--tries              %ld\n", max_tries);
-        fprintf(log_file, "--tours              %ld\n", max_tours);
-        fprintf(log_file, "--ptries             %ld\n", max_packing_tries);    
-        fprintf(log_file, "--time               %.2f\n", max_time);
-        fprintf(log_file, "--seed               %ld\n", seed);
-        fprintf(log_file, "--optimum            %ld\n", optimal);
-        fprintf(log_file, "--ants               %ld\n", n_ants);
-        fprintf(log_file, "--nnants             %ld\n", nn_ants);
-        fprintf(log_file, "--alpha              %.2f\n", alpha);
-        fprintf(log_file, "--beta               %.2f\n", beta);
-        fprintf(log_file, "--rho                %.2f\n", rho);
-        fprintf(log_file, "--q0                 %.2f\n", q_0);
-        fprintf(log_file, "--elitistants        %ld\n", elitist_ants);
-        fprintf(log_file, "--rasranks           %ld\n", ras_ranks);
-        fprintf(log_file, "--localsearch        %ld\n", ls_flag);
-        fprintf(log_file, "--nnls               %ld\n", nn_ls);
-        fprintf(log_file, "--dlb                %ld\n", dlb_flag);
-        fprintf(log_file, "--as                 %ld\n", as_flag);
-        fprintf(log_file, "--eas                %ld\n", eas_flag);
-        fprintf(log_file, "--ras                %ld\n", ras_flag);
-        fprintf(log_file, "--mmas               %ld\n", mmas_flag);
-        fprintf(log_file, "--bwas               %ld\n", bwas_flag);
-        fprintf(log_file, "--acs                %ld\n\n", acs_flag);
-    }
+    if (log_file)
+        print_params(log_file);
+    if ( checkpoint_period > 0. || resume_flag )
+        params_checksum = parameter_checksum();
 }
@@ -60,15 +60,18 @@ extern long int *best_in_try;
 extern long int *best_found_at;
 extern double   *time_best_found;
 extern double   *time_total_run;   
+extern long int *evaluations_best_found;
 
 extern long int n_try;        /* number of try */
 extern long int n_tours;      /* number of constructed tours */
+extern long int n_evaluations; /* number of packing plans evaluated by compute_fitness */
 extern long int iteration;    /* iteration counter */
 extern long int restart_iteration;    /* iteration counter */
 extern double   restart_time; /* remember when restart was done if any */
 
 extern long int max_tries;    /* maximum number of independent tries */
 extern long int max_tours;    /* maximum number of tour constructions in one try */
+extern long int max_evaluations; /* maximum number of packing plan evaluations in one try, 0 = no limit */
 
 extern long int max_packing_tries; /* number of tries to construct a good packing plan from a give tour */
 
@@ -80,12 +83,15 @@ extern double   time_used;    /* time used until some given event */
 extern double   time_passed;  /* time passed until some moment*/
 extern long int optimal;      /* optimal solution value or bound to find */
 
-extern double mean_ants;      /* average tour length */
-extern double stddev_ants;    /* stddev of tour lengths */
+extern double mean_ants;      /* average fitness of the ants */
+extern double stddev_ants;    /* stddev of the fitness of the ants */
+extern double distance_ants;  /* average number of arcs in which the tours of two ants differ */
+extern double restart_distance; /* If distance_ants < restart_distance * n => update trails */
 extern double branching_factor; /* average node branching factor when searching */
 extern double found_branching;  /* branching factor when best solution is found */
 
 extern long int found_best;         /* iteration in which best solution is found */
+extern long int found_evaluations;  /* evaluations until the best solution is found */
 extern long int restart_found_best; /* iteration in which restart-best solution is found */
 
 extern FILE *log_file;
@@ -96,6 +102,19 @@ extern int  opt;
 extern long int log_flag;
 extern long int output_flag; 
 extern long int calibration_mode; 
+extern long int reduce_flag;  /* skip construction steps for cities that cannot be visited */
+
+#define CAND_NEAREST   0      /* candidate lists of nearest neighbours */
+#define CAND_QUADRANT  1      /* nearest neighbours balanced over the four quadrants */
+#define CAND_ALPHA     2      /* alpha-nearness w.r.t. the minimum spanning tree */
+
+extern long int candidate_flag;  /* how the candidate lists are computed */
+extern char candidate_cache_name[LINE_BUF_LEN];  /* file of cached candidate lists, empty if none */
+
+#define CHECKPOINT_HEADER 10  /* entries of the header that identifies instance and parameters of a checkpoint */
+
+extern double   checkpoint_period; /* seconds of wall-clock time between two checkpoints, 0 = none */
+extern long int resume_flag;       /* continue from <outputfile>.ckpt if it exists */
 
 void init_program(long int argc, char **argv);
 
@@ -105,7 +124,7 @@ void init_try(long int ntry);
 
 void exit_try(long int ntry);
 
-/*void read_thop_instance(const char *input_file_name, struct point **nodeptr, struct item **itemptr);*/
+/*void read_thop_instance(const char *input_file_name, struct point **nodeptr);*/
 
 void set_default_parameters();
 
@@ -119,12 +138,28 @@ void set_default_mmas_parameters(void);
 
 void set_default_bwas_parameters(void);
 
+void set_default_paco_parameters(void);
+
 void set_default_acs_parameters(void);
 
 void set_default_ls_parameters(void);
 
 void save_best_thop_solution(void);
 
+void write_compiled_instance(const char *file_name);
+
+long int **compiled_distances(void);
+
+long int **compiled_nn_lists(long int nn, long int prefix);
+
+unsigned long word_checksum(unsigned long h, const void *p, size_t bytes);
+
+void write_checkpoint(void);
+
+long int checkpoint_try(void);
+
+void read_checkpoint(void);
+
 void write_report(void);
 
 void write_params(void);
\ No newline at end of file
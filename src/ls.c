@@ -55,10 +55,10 @@
 #include <stdlib.h>
 #include <limits.h>
 
-#include "ls.h"
 #include "inout.h"
 #include "thop.h"
 #include "ants.h"
+#include "ls.h"
 #include "utilities.h"
 
 long int ls_flag;          /* indicates whether and which local search is used */ 
@@ -67,29 +67,161 @@ long int nn_ls;            /* maximal depth of nearest neighbour lists used in t
 long int dlb_flag = TRUE;  /* flag indicating whether don't look bits are used. I recommend 
                               to always use it if local search is applied */
 
-long int * generate_random_permutation( long int n )
+long int ls_policy = LS_ALL;  /* which ants are searched in each iteration, see LS_* in ls.h */
+long int ls_ants = 5;         /* number of ants searched by LS_TOP_K, expected number for LS_RANK */
+double   ls_budget = 1.0;     /* wall-clock seconds per iteration for LS_BUDGET */
+
+long int ls_calls;     /* number of local search calls in the current try */
+long int ls_improved;  /* number of calls that improved the fitness */
+long int ls_gain;      /* sum of the fitness improvements */
+double   ls_time;      /* wall-clock time spent in the local search phase */
+
+long int *thop_item_order;  /* packable items by decreasing profit / weight */
+long int n_thop_items;      /* number of items in thop_item_order */
+
+long int *ls_reference;      /* tour whose arcs need not be searched again, see init_scan */
+long int *ls_reference_pos;  /* positions of the cities in ls_reference */
+
+ls_context **ls_workspaces;  /* scratch space of the local search, one per worker thread */
+long int n_ls_workspaces;    /* number of contexts in ls_workspaces */
+
+ls_context * allocate_ls_context( long int n )
+/*    
+      FUNCTION:       allocate the scratch space of the local search procedures
+      INPUT:          number of cities
+      OUTPUT:         pointer to the context
+      (SIDE)EFFECTS:  all vectors are allocated for n cities; the context draws its 
+                      random numbers from the global seed until local_search gives 
+                      it the stream of an ant
+      COMMENTS:       a context may be passed to any number of local search calls, but 
+                      only one call at a time may use it
+ */
+{
+    ls_context *ctx;
+    long int i;
+
+    if ( (ctx = malloc(sizeof(ls_context))) == NULL ||
+         (ctx->pos = malloc(15 * (n + 1) * sizeof(long int))) == NULL ||
+         (ctx->arrival = malloc(2 * (n + 1) * sizeof(double))) == NULL ) {
+        printf("Out of memory, exit.");
+        exit(1);
+    }
+    ctx->dlb = ctx->pos + (n + 1);
+    ctx->random_vector = ctx->dlb + (n + 1);
+    ctx->h_tour = ctx->random_vector + (n + 1);
+    ctx->hh_tour = ctx->h_tour + (n + 1);
+    ctx->route = ctx->hh_tour + (n + 1);
+    ctx->route_pos = ctx->route + (n + 1);
+    ctx->city_weight = ctx->route_pos + (n + 1);
+    ctx->city_profit = ctx->city_weight + (n + 1);
+    ctx->weight_after = ctx->city_profit + (n + 1);
+    ctx->seq = ctx->weight_after + (n + 1);
+    ctx->seq_weight = ctx->seq + (n + 1);
+    ctx->length = ctx->seq_weight + (n + 1);
+    ctx->prefix_tour = ctx->length + (n + 1);
+    ctx->scan_stamp = ctx->prefix_tour + (n + 1);
+    for ( i = 0 ; i <= n ; i++ )
+        ctx->scan_stamp[i] = 0;
+    ctx->scan_epoch = 0;
+    ctx->slope = ctx->arrival + (n + 1);
+    ctx->rng = &seed;
+    return ctx;
+}
+
+void free_ls_context( ls_context *ctx )
+/*    
+      FUNCTION:       free a context allocated by allocate_ls_context
+      INPUT:          pointer to the context
+      OUTPUT:         none
+      (SIDE)EFFECTS:  memory of the context is freed
+ */
+{
+    free( ctx->pos );
+    free( ctx->arrival );
+    free( ctx );
+}
+
+void allocate_ls_workspaces( long int n_workers )
+/*    
+      FUNCTION:       allocate one local search context for each worker thread
+      INPUT:          number of worker threads
+      OUTPUT:         none
+      (SIDE)EFFECTS:  ls_workspaces and n_ls_workspaces are set, ls_reference_pos is 
+                      allocated
+ */
+{
+    long int w;
+
+    n_ls_workspaces = n_workers;
+    if ( (ls_workspaces = malloc(n_workers * sizeof(ls_context *))) == NULL ||
+         (ls_reference_pos = malloc(instance.n * sizeof(long int))) == NULL ) {
+        printf("Out of memory, exit.");
+        exit(1);
+    }
+    ls_reference = NULL;
+    for ( w = 0 ; w < n_workers ; w++ )
+        ls_workspaces[w] = allocate_ls_context( instance.n );
+    if ( ls_flag == 4 )
+        init_thop_item_order();
+}
+
+void free_ls_workspaces( void )
+/*    
+      FUNCTION:       free the contexts allocated by allocate_ls_workspaces
+      INPUT:          none
+      OUTPUT:         none
+      (SIDE)EFFECTS:  memory of ls_workspaces is freed
+ */
+{
+    long int w;
+
+    for ( w = 0 ; w < n_ls_workspaces ; w++ )
+        free_ls_context( ls_workspaces[w] );
+    free( ls_workspaces );
+    free( ls_reference_pos );
+    if ( ls_flag == 4 )
+        free( thop_item_order );
+}
+
+void set_ls_reference( long int *tour )
+/*    
+      FUNCTION:       set the reference tour of the local search
+      INPUT:          tour of instance.n cities, or NULL
+      OUTPUT:         none
+      (SIDE)EFFECTS:  ls_reference and ls_reference_pos are set
+      COMMENTS:       with dlb_flag 2, the local search starts only from the cities at 
+                      arcs that are not in the reference tour, see init_scan; the tour 
+                      must not change while it is the reference
+ */
+{
+    long int i;
+
+    ls_reference = tour;
+    if ( tour == NULL )
+        return;
+    for ( i = 0 ; i < instance.n ; i++ )
+        ls_reference_pos[tour[i]] = i;
+}
+
+void random_permutation( long int *r, long int n, long int *idum )
 /*    
       FUNCTION:       generate a random permutation of the integers 0 .. n-1
-      INPUT:          length of the array
-      OUTPUT:         pointer to the random permutation
-      (SIDE)EFFECTS:  the array holding the random permutation is allocated in this 
-                      function. Don't forget to free again the memory!
+      INPUT:          array of length n, length of the array, random number generator state
+      OUTPUT:         none
+      (SIDE)EFFECTS:  r holds the random permutation
       COMMENTS:       only needed by the local search procedures
  */
 {
 
     long int  i, help, node, tot_assigned = 0;
     double    rnd;
-    long int  *r;
-
-    r = malloc(n * sizeof(long int));
 
     for ( i = 0 ; i < n; i++)
         r[i] = i;
 
     for ( i = 0 ; i < n ; i++ ) {
         /* find (randomly) an index for a free unit */
-        rnd  = ran01 ( &seed );
+        rnd  = ran01 ( idum );
         node = (long int) (rnd  * (n - tot_assigned));
         assert( i + node < n );
         help = r[i];
@@ -97,13 +229,91 @@ long int * generate_random_permutation( long int n )
         r[i+node] = help;
         tot_assigned++;
     }
-    return r;
 }
 
-void two_opt_first( long int *tour, long int n ) 
+/* TRUE if city c is one of the n cities of tour; pos is valid for these cities only */
+#define ON_TOUR(c)  ( n == instance.n || ( ctx->pos[c] >= 0 && ctx->pos[c] < n && tour[ctx->pos[c]] == (c) ) )
+
+static void wake_city( ls_context *ctx, long int c )
+/*
+      FUNCTION:       reset the don't look bit of city c
+      INPUT:          scratch space of the local search, city
+      OUTPUT:         none
+      (SIDE)EFFECTS:  c is appended to the cities to scan if it is not among them
+ */
+{
+    ctx->dlb[c] = FALSE;
+    if ( ctx->scan_stamp[c] != ctx->scan_epoch ) {
+        ctx->scan_stamp[c] = ctx->scan_epoch;
+        ctx->random_vector[ctx->n_scan++] = c;
+    }
+}
+
+static long int ref_adjacent( long int a, long int b )
+/*
+      FUNCTION:       check whether a and b are neighbours in ls_reference
+      INPUT:          two cities
+      OUTPUT:         TRUE if the arc (a,b) is in the reference tour
+ */
+{
+    long int p = ls_reference_pos[a];
+
+    return ( ls_reference[p + 1] == b || ls_reference[p > 0 ? p - 1 : instance.n - 1] == b );
+}
+
+static void init_scan( long int *tour, long int n, ls_context *ctx )
+/*
+      FUNCTION:       prepare a local search on a tour
+      INPUT:          pointer to the tour, number of cities in the tour, scratch space
+                      of the local search
+      OUTPUT:         none
+      (SIDE)EFFECTS:  positions of the cities of tour are set; the cities to scan are 
+                      the first n_scan entries of random_vector, in random order, and 
+                      their don't look bits are reset
+      COMMENTS:       tour may contain only some of the cities of the instance (see
+                      prefix_local_search); the work is linear in its length. If 
+                      dlb_flag is 2 and a reference tour is set, only the end points 
+                      of the arcs of tour that are not in the reference are scanned at 
+                      first; the other cities keep their don't look bits set and are 
+                      appended by wake_city once an exchange touches them
+ */
+{
+    long int i, k, help;
+
+    ctx->scan_epoch++;
+    for ( i = 0 ; i < n ; i++ )
+        ctx->pos[tour[i]] = i;
+    if ( dlb_flag == 2 && ls_reference != NULL ) {
+        ctx->n_scan = 0;
+        for ( i = 0 ; i < n ; i++ ) {
+            if ( !ref_adjacent( tour[i], tour[i + 1] ) ) {
+                wake_city( ctx, tour[i] );
+                wake_city( ctx, tour[i + 1] );
+            }
+        }
+        for ( i = ctx->n_scan - 1 ; i > 0 ; i-- ) {
+            k = (long int) ( ran01( ctx->rng ) * (double) ( i + 1 ) );
+            help = ctx->random_vector[i];
+            ctx->random_vector[i] = ctx->random_vector[k];
+            ctx->random_vector[k] = help;
+        }
+        return;
+    }
+    for ( i = 0 ; i < n ; i++ ) {
+        ctx->dlb[tour[i]] = FALSE;
+        ctx->scan_stamp[tour[i]] = ctx->scan_epoch;
+    }
+    random_permutation( ctx->random_vector, n, ctx->rng );
+    for ( i = 0 ; i < n ; i++ )
+        ctx->random_vector[i] = tour[ctx->random_vector[i]];
+    ctx->n_scan = n;
+}
+
+void two_opt_first( long int *tour, long int n, ls_context *ctx ) 
 /*    
       FUNCTION:       2-opt a tour 
-      INPUT:          pointer to the tour that undergoes local optimization
+      INPUT:          pointer to the tour that undergoes local optimization, 
+                      scratch space of the local search
       OUTPUT:         none
       (SIDE)EFFECTS:  tour is 2-opt
       COMMENTS:       the neighbourhood is scanned in random order (this need 
@@ -113,6 +323,10 @@ void two_opt_first( long int *tour, long int n )
                       Stochastic Local Search---Foundations and Applications, 
                       Morgan Kaufmann Publishers, 2004.
                       or some of the papers online available from David S. Johnson.
+                      The tour is kept in an array, so a move reverses up to n/2 
+                      cities. On the ThOP tours the fixed radius moves reverse few 
+                      cities, and the reversals take a small part of the time of 
+                      prefix_local_search
  */
 {
 
@@ -129,24 +343,21 @@ void two_opt_first( long int *tour, long int n )
     long int *pos;               /* positions of cities in tour */
     long int *dlb;               /* vector containing don't look bits */
 
-    pos = malloc(n * sizeof(long int));
-    dlb = malloc(n * sizeof(long int));
-    for ( i = 0 ; i < n ; i++ ) {
-        pos[tour[i]] = i;
-        dlb[i] = FALSE;
-    }
+    pos = ctx->pos;
+    dlb = ctx->dlb;
 
+    init_scan( tour, n, ctx );
     improvement_flag = TRUE;
-    random_vector = generate_random_permutation( n );
+    random_vector = ctx->random_vector;
 
     while ( improvement_flag ) {
 
         improvement_flag = FALSE;
 
-        for (l = 0 ; l < n; l++) {
+        for (l = 0 ; l < ctx->n_scan; l++) {
 
             c1 = random_vector[l];
-            DEBUG ( assert ( c1 < n && c1 >= 0); )
+            DEBUG ( assert ( c1 < instance.n && c1 >= 0); )
             if ( dlb_flag && dlb[c1] )
                 continue;
             pos_c1 = pos[c1];
@@ -156,6 +367,8 @@ void two_opt_first( long int *tour, long int n )
             /* First search for c1's nearest neighbours, use successor of c1 */
             for ( h = 0 ; h < nn_ls ; h++ ) {
                 c2 = instance.nn_list[c1][h]; /* exchange partner, determine its position */
+                if ( !ON_TOUR(c2) )
+                    continue;
                 if ( radius > instance.distance[c1][c2] ) {
                     s_c2 = tour[pos[c2]+1];
                     gain =  - radius + instance.distance[c1][c2] +
@@ -165,6 +378,8 @@ void two_opt_first( long int *tour, long int n )
                         goto exchange2opt;
                     }
                 }
+                else if ( h < instance.nn_split )
+                    h = instance.nn_split - 1;  /* go on with the second part of the list */
                 else
                     break;
             }
@@ -176,6 +391,8 @@ void two_opt_first( long int *tour, long int n )
             radius = instance.distance[p_c1][c1];
             for ( h = 0 ; h < nn_ls ; h++ ) {
                 c2 = instance.nn_list[c1][h];  /* exchange partner, determine its position */
+                if ( !ON_TOUR(c2) )
+                    continue;
                 if ( radius > instance.distance[c1][c2] ) {
                     pos_c2 = pos[c2];
                     if (pos_c2 > 0)
@@ -193,6 +410,8 @@ void two_opt_first( long int *tour, long int n )
                         goto exchange2opt;
                     }
                 }
+                else if ( h < instance.nn_split )
+                    h = instance.nn_split - 1;  /* go on with the second part of the list */
                 else
                     break;
             }
@@ -203,8 +422,8 @@ void two_opt_first( long int *tour, long int n )
             exchange2opt:
             n_exchanges++;
             improvement_flag = TRUE;
-            dlb[h1] = FALSE; dlb[h2] = FALSE;
-            dlb[h3] = FALSE; dlb[h4] = FALSE;
+            wake_city( ctx, h1 ); wake_city( ctx, h2 );
+            wake_city( ctx, h3 ); wake_city( ctx, h4 );
             /* Now perform move */
             if ( pos[h3] < pos[h1] ) {
                 help = h1; h1 = h3; h3 = help;
@@ -251,15 +470,13 @@ void two_opt_first( long int *tour, long int n )
             n_improves++;
         }
     }
-    free( random_vector );
-    free( dlb );
-    free( pos );
 }
 
-void two_h_opt_first( long int *tour, long int n ) 
+void two_h_opt_first( long int *tour, long int n, ls_context *ctx ) 
 /*    
       FUNCTION:       2-h-opt a tour
-      INPUT:          pointer to the tour that undergoes local optimization
+      INPUT:          pointer to the tour that undergoes local optimization, 
+                      scratch space of the local search
       OUTPUT:         none
       (SIDE)EFFECTS:  tour is 2-h-opt
       COMMENTS:       for details on 2-h-opt see J. L. Bentley. Fast algorithms for geometric 
@@ -290,24 +507,21 @@ void two_h_opt_first( long int *tour, long int n )
     long int *pos;               /* positions of cities in tour */
     long int *dlb;               /* vector containing don't look bits */
 
-    pos = malloc(n * sizeof(long int));
-    dlb = malloc(n * sizeof(long int));
-    for ( i = 0 ; i < n ; i++ ) {
-        pos[tour[i]] = i;
-        dlb[i] = FALSE;
-    }
+    pos = ctx->pos;
+    dlb = ctx->dlb;
 
+    init_scan( tour, n, ctx );
     improvement_flag = TRUE;
-    random_vector = generate_random_permutation( n );
+    random_vector = ctx->random_vector;
 
     while ( improvement_flag ) {
 
         improvement_flag = FALSE; two_move = FALSE; node_move = FALSE;
 
-        for (l = 0 ; l < n; l++) {
+        for (l = 0 ; l < ctx->n_scan; l++) {
 
             c1 = random_vector[l];
-            DEBUG ( assert ( c1 < n && c1 >= 0); )
+            DEBUG ( assert ( c1 < instance.n && c1 >= 0); )
             if ( dlb_flag && dlb[c1] )
                 continue;
             improve_node = FALSE;
@@ -318,6 +532,8 @@ void two_h_opt_first( long int *tour, long int n )
             /* First search for c1's nearest neighbours, use successor of c1 */
             for ( h = 0 ; h < nn_ls ; h++ ) {
                 c2 = instance.nn_list[c1][h]; /* exchange partner, determine its position */
+                if ( !ON_TOUR(c2) )
+                    continue;
                 if ( radius > instance.distance[c1][c2] ) {
                     pos_c2 = pos[c2];
                     s_c2 = tour[pos_c2+1];
@@ -348,6 +564,8 @@ void two_h_opt_first( long int *tour, long int n )
                         goto exchange;
                     }
                 }
+                else if ( h < instance.nn_split )
+                    h = instance.nn_split - 1;  /* go on with the second part of the list */
                 else
                     break;
             }
@@ -359,6 +577,8 @@ void two_h_opt_first( long int *tour, long int n )
             radius = instance.distance[p_c1][c1];
             for ( h = 0 ; h < nn_ls ; h++ ) {
                 c2 = instance.nn_list[c1][h];  /* exchange partner, determine its position */
+                if ( !ON_TOUR(c2) )
+                    continue;
                 if ( radius > instance.distance[c1][c2] ) {
                     pos_c2 = pos[c2];
                     if (pos_c2 > 0)
@@ -391,6 +611,8 @@ void two_h_opt_first( long int *tour, long int n )
                         goto exchange;
                     }
                 }
+                else if ( h < instance.nn_split )
+                    h = instance.nn_split - 1;  /* go on with the second part of the list */
                 else
                     break;
             }
@@ -398,8 +620,8 @@ void two_h_opt_first( long int *tour, long int n )
             if (improve_node) {
                 if ( two_move ) {
                     improvement_flag = TRUE;
-                    dlb[h1] = FALSE; dlb[h2] = FALSE;
-                    dlb[h3] = FALSE; dlb[h4] = FALSE;
+                    wake_city( ctx, h1 ); wake_city( ctx, h2 );
+                    wake_city( ctx, h3 ); wake_city( ctx, h4 );
                     /* Now perform move */
                     if ( pos[h3] < pos[h1] ) {
                         help = h1; h1 = h3; h3 = help;
@@ -443,8 +665,8 @@ void two_h_opt_first( long int *tour, long int n )
                     }
                 } else if ( node_move ) {
                     improvement_flag = TRUE;
-                    dlb[h1] = FALSE; dlb[h2] = FALSE; dlb[h3] = FALSE;
-                    dlb[h4] = FALSE; dlb[h5] = FALSE;
+                    wake_city( ctx, h1 ); wake_city( ctx, h2 ); wake_city( ctx, h3 );
+                    wake_city( ctx, h4 ); wake_city( ctx, h5 );
                     /* Now perform move */
                     if ( pos[h3] < pos[h1] ) {
                         help = pos[h1] - pos[h3];
@@ -485,16 +707,14 @@ void two_h_opt_first( long int *tour, long int n )
 
         }
     }
-    free( random_vector );
-    free( dlb );
-    free( pos );
 }
 
-void three_opt_first( long int *tour, long int n )
+void three_opt_first( long int *tour, long int n, ls_context *ctx )
 
 /*    
       FUNCTION:       3-opt the tour
-      INPUT:          pointer to the tour that is to optimize
+      INPUT:          pointer to the tour that is to optimize, scratch space of the 
+                      local search
       OUTPUT:         none
       (SIDE)EFFECTS:  tour is 3-opt
       COMMENT:        this is certainly not the best possible implementation of a 3-opt 
@@ -542,23 +762,20 @@ void three_opt_first( long int *tour, long int n )
     long int *hh_tour;           /* help vector for performing exchange move */
     long int *random_vector;
 
-    pos = malloc(n * sizeof(long int));
-    dlb = malloc(n * sizeof(long int));
-    h_tour = malloc(n * sizeof(long int));
-    hh_tour = malloc(n * sizeof(long int));
+    pos = ctx->pos;
+    dlb = ctx->dlb;
+    h_tour = ctx->h_tour;
+    hh_tour = ctx->hh_tour;
 
-    for ( i = 0 ; i < n ; i++ ) {
-        pos[tour[i]] = i;
-        dlb[i] = FALSE;
-    }
+    init_scan( tour, n, ctx );
     improvement_flag = TRUE;
-    random_vector = generate_random_permutation( n );
+    random_vector = ctx->random_vector;
 
     while ( improvement_flag ) {
         move_value = 0;
         improvement_flag = FALSE;
 
-        for ( l = 0 ; l < n ; l++ ) {
+        for ( l = 0 ; l < ctx->n_scan ; l++ ) {
 
             c1 = random_vector[l];
             if ( dlb_flag && dlb[c1] )
@@ -577,6 +794,10 @@ void three_opt_first( long int *tour, long int n )
             while ( h < nn_ls ) {
 
                 c2   = instance.nn_list[c1][h];  /* second city, determine its position */
+                if ( !ON_TOUR(c2) ) {
+                    h++;
+                    continue;
+                }
                 pos_c2 = pos[c2];
                 s_c2 = tour[pos_c2+1];
                 if (pos_c2 > 0)
@@ -596,6 +817,10 @@ void three_opt_first( long int *tour, long int n )
                     diffp =  - radius - instance.distance[c2][p_c2] +
                             instance.distance[c1][p_c2] + instance.distance[s_c1][c2];
                 }
+                else if ( h < instance.nn_split ) {
+                    h = instance.nn_split;  /* go on with the second part of the list */
+                    continue;
+                }
                 else
                     break;
                 if ( p_c2 == c1 )  /* in case p_c2 == c1 no exchange is possible */
@@ -619,6 +844,10 @@ void three_opt_first( long int *tour, long int n )
                 while (g < nn_ls) {
 
                     c3   = instance.nn_list[s_c1][g];
+                    if ( !ON_TOUR(c3) ) {
+                        g++;
+                        continue;
+                    }
                     pos_c3 = pos[c3];
                     s_c3 = tour[pos_c3+1];
                     if (pos_c3 > 0)
@@ -732,8 +961,8 @@ void three_opt_first( long int *tour, long int n )
                                    }
                             }
                         }
-                        else
-                            g = nn_ls + 1;
+                        else  /* beyond the radius, go on with the second part of the list if any */
+                            g = ( g < instance.nn_split ) ? instance.nn_split - 1 : nn_ls + 1;
                     }
                     g++;
                 }
@@ -745,8 +974,8 @@ void three_opt_first( long int *tour, long int n )
 
                 /* Now make the exchange */
                 if ( move_flag ) {
-                    dlb[h1] = FALSE; dlb[h2] = FALSE; dlb[h3] = FALSE;
-                    dlb[h4] = FALSE; dlb[h5] = FALSE; dlb[h6] = FALSE;
+                    wake_city( ctx, h1 ); wake_city( ctx, h2 ); wake_city( ctx, h3 );
+                    wake_city( ctx, h4 ); wake_city( ctx, h5 ); wake_city( ctx, h6 );
                     pos_c1 = pos[h1]; pos_c2 = pos[h3]; pos_c3 = pos[h5];
 
                     if ( move_flag == 4 ) {
@@ -1474,8 +1703,8 @@ void three_opt_first( long int *tour, long int n )
                 if (opt2_flag) {
 
                     /* Now perform move */
-                    dlb[h1] = FALSE; dlb[h2] = FALSE;
-                    dlb[h3] = FALSE; dlb[h4] = FALSE;
+                    wake_city( ctx, h1 ); wake_city( ctx, h2 );
+                    wake_city( ctx, h3 ); wake_city( ctx, h4 );
                     if ( pos[h3] < pos[h1] ) {
                         help = h1; h1 = h3; h3 = help;
                         help = h2; h2 = h4; h4 = help;
@@ -1523,9 +1752,601 @@ void three_opt_first( long int *tour, long int n )
             }
         }
     }
-    free( random_vector );
-    free( h_tour );
-    free( hh_tour );
-    free( pos );
-    free( dlb );
+}
+
+long int active_prefix( ant_struct *a )
+/*
+      FUNCTION:       determine the part of a ThOP tour that the local search considers
+      INPUT:          pointer to the ant
+      OUTPUT:         last position of the active prefix of the tour
+      (SIDE)EFFECTS:  none
+      COMMENTS:       the thief goes from the last city with a picked item directly to
+                      the end city, so the rest of the tour does not affect the fitness.
+                      If no item is picked, the prefix ends where the tour length exceeds
+                      what the empty thief can travel within max_time. PREFIX_MARGIN
+                      further cities are added, which may enter the prefix
+ */
+{
+    long int i, j, c, last = 0;
+    double length = 0.;
+
+    for ( i = a->n_constructed ; i > 0 && last == 0 ; i-- ) {
+        c = a->tour[i];
+        for ( j = instance.city_items[c] ; j < instance.city_items[c + 1] ; j++ ) {
+            if ( BITSET_TEST(a->packing_plan, j) ) {
+                last = i;
+                break;
+            }
+        }
+    }
+    if ( last == 0 ) {
+        for ( i = 1 ; i <= a->n_constructed ; i++ ) {
+            length += instance.distance[a->tour[i - 1]][a->tour[i]];
+            if ( length > instance.max_time * instance.max_speed )
+                break;
+            last = i;
+        }
+    }
+    return MIN(last + PREFIX_MARGIN, instance.n - 3);
+}
+
+void prefix_local_search( ant_struct *a, ls_context *ctx )
+/*
+      FUNCTION:       apply 2-opt, 2.5-opt or 3-opt to the active prefix of a ThOP tour
+      INPUT:          pointer to the ant, scratch space of the local search
+      OUTPUT:         none
+      (SIDE)EFFECTS:  the cities of the active prefix are reordered, the rest of the
+                      tour is unchanged; the constructed part of the tour is extended
+                      to the active prefix. The fitness is not updated
+      COMMENTS:       the operators work on the closed tour 0, prefix, end city, dummy
+                      city. As in the complete ThOP tour, the dummy city is at distance
+                      0 from city 0 and the end city and far from all others, so no
+                      improving move separates them. Neighbours outside this tour are
+                      skipped, and positions, don't look bits and the scan order are
+                      only set for its cities; hence, the time needed depends on the
+                      length of the prefix and not on n
+ */
+{
+    long int i, j, m, limit;
+    long int *t = ctx->prefix_tour;
+
+    limit = active_prefix( a );
+    for ( i = 0 ; i <= limit ; i++ )
+        t[i] = a->tour[i];
+    t[limit + 1] = instance.n - 2;
+    t[limit + 2] = instance.n - 1;
+    m = limit + 3;
+    t[m] = t[0];
+
+    switch (ls_flag) {
+    case 1:
+        two_opt_first( t, m, ctx );    /* 2-opt local search */
+        break;
+    case 2:
+        two_h_opt_first( t, m, ctx );  /* 2.5-opt local search */
+        break;
+    case 3:
+        three_opt_first( t, m, ctx );  /* 3-opt local search */
+        break;
+    default:
+        fprintf(stderr,"type of local search procedure not correctly specified\n");
+        exit(1);
+    }
+
+    /* copy back the prefix, starting at city 0 and away from the dummy city */
+    for ( j = 0 ; t[j] != 0 ; j++ )
+        ;
+    if ( t[j + 1] != instance.n - 1 ) {
+        for ( i = 1 ; i <= limit ; i++ )
+            a->tour[i] = t[(j + i) % m];
+    }
+    else {
+        for ( i = 1 ; i <= limit ; i++ )
+            a->tour[i] = t[(j - i + m) % m];
+    }
+    if ( a->n_constructed < limit )
+        a->n_constructed = limit;
+}
+
+/**************************************************************************
+ **************************************************************************
+ Local search for the ThOP: the route of the cities at which items are 
+ picked is improved with respect to the travel time, and items are added 
+ as long as the capacity and the maximum time allow it
+ ***************************************************************************
+ **************************************************************************/
+
+void init_thop_item_order( void )
+/*    
+      FUNCTION:       sort the packable items by decreasing ratio of profit and weight
+      INPUT:          none
+      OUTPUT:         none
+      (SIDE)EFFECTS:  thop_item_order and n_thop_items are set
+      COMMENTS:       items are tried for insertion in this order by thop_local_search
+ */
+{
+    long int j;
+    sort_pair_double *p;
+
+    thop_item_order = malloc(instance.m * sizeof(long int));
+    p = malloc(instance.m * sizeof(sort_pair_double));
+    n_thop_items = 0;
+    for ( j = 0 ; j < instance.m ; j++ ) {
+        if ( !instance.item_packable[j] || instance.item_city[j] == 0 )
+            continue;
+        p[n_thop_items].key = - (double) instance.item_profit[j] / (double) instance.item_weight[j];
+        p[n_thop_items++].index = j;
+    }
+    sort_pairs_double(p, n_thop_items);
+    for ( j = 0 ; j < n_thop_items ; j++ )
+        thop_item_order[j] = p[j].index;
+    free( p );
+}
+
+static double thop_arrival( long int *seq, long int *seq_weight, long int len, double t, long int w )
+/*    
+      FUNCTION:       travel time along a sequence of cities
+      INPUT:          cities seq[0..len-1], weight picked at each of them, arrival time 
+                      t and carried weight w at seq[0] before picking there
+      OUTPUT:         arrival time at seq[len-1]
+      (SIDE)EFFECTS:  none
+      COMMENTS:       the speed decreases linearly with the carried weight as in 
+                      compute_fitness
+ */
+{
+    long int i;
+    const double v = ( instance.max_speed - instance.min_speed ) / instance.capacity_of_knapsack;
+
+    for ( i = 0 ; i < len - 1 ; i++ ) {
+        w += seq_weight[i];
+        t += instance.distance[seq[i]][seq[i+1]] / ( instance.max_speed - v * w );
+    }
+    return t;
+}
+
+static void thop_route_prefix( ls_context *ctx, long int from, long int m )
+/*    
+      FUNCTION:       recompute carried weights and arrival times along the route
+      INPUT:          scratch space holding the route, first position that changed, 
+                      number m of cities strictly between the start and the end city
+      OUTPUT:         none
+      (SIDE)EFFECTS:  route_pos, weight_after, length, arrival and slope are updated 
+                      from position from on
+      COMMENTS:       slope[i] sums v * d / s^2 over the legs before route[i], where 
+                      d is the length and s the speed of a leg. Since the time of a 
+                      leg is convex in the carried weight, picking additional weight w 
+                      at route[p] delays the arrival at the end city by at least 
+                      w * (slope[m+1] - slope[p]), and dropping weight w there saves 
+                      at most as much
+ */
+{
+    long int i;
+    long int *r = ctx->route;
+    double s, d;
+    const double v = ( instance.max_speed - instance.min_speed ) / instance.capacity_of_knapsack;
+
+    if ( from == 0 ) {
+        ctx->weight_after[0] = 0;  /* as in compute_fitness, no weight is carried from city 0 */
+        ctx->arrival[0] = 0.;
+        ctx->slope[0] = 0.;
+        ctx->length[0] = 0;
+        ctx->route_pos[r[0]] = 0;
+        from = 1;
+    }
+    for ( i = from ; i <= m + 1 ; i++ ) {
+        ctx->route_pos[r[i]] = i;
+        s = instance.max_speed - v * ctx->weight_after[i-1];
+        d = instance.distance[r[i-1]][r[i]];
+        ctx->arrival[i] = ctx->arrival[i-1] + d / s;
+        ctx->slope[i] = ctx->slope[i-1] + v * d / ( s * s );
+        ctx->length[i] = ctx->length[i-1] + instance.distance[r[i-1]][r[i]];
+        ctx->weight_after[i] = ctx->weight_after[i-1] + ctx->city_weight[r[i]];
+    }
+}
+
+static long int thop_window( ls_context *ctx, long int a, long int b )
+/*    
+      FUNCTION:       copy positions a..b of the route with their picked weights into seq
+      INPUT:          scratch space, first and last position
+      OUTPUT:         number of cities copied
+      (SIDE)EFFECTS:  seq and seq_weight hold the window
+ */
+{
+    long int i;
+
+    for ( i = a ; i <= b ; i++ ) {
+        ctx->seq[i-a] = ctx->route[i];
+        ctx->seq_weight[i-a] = ( i == 0 ) ? 0 : ctx->city_weight[ctx->route[i]];
+    }
+    return b - a + 1;
+}
+
+static double thop_window_arrival( ls_context *ctx, long int a, long int len )
+/*    
+      FUNCTION:       arrival time at the end of seq if it replaces the route from position a on
+      INPUT:          scratch space, position a, length of seq
+      OUTPUT:         arrival time at seq[len-1]
+ */
+{
+    return thop_arrival( ctx->seq, ctx->seq_weight, len, ctx->arrival[a], 
+                         ( a == 0 ) ? 0 : ctx->weight_after[a-1] );
+}
+
+static void thop_apply_window( ls_context *ctx, long int a, long int len, long int m )
+/*    
+      FUNCTION:       replace the route from position a on by seq
+      INPUT:          scratch space, position a, length of seq, number of route cities 
+                      after the move
+      OUTPUT:         none
+      (SIDE)EFFECTS:  route and its prefix data are updated
+ */
+{
+    long int i;
+
+    for ( i = 0 ; i < len ; i++ )
+        ctx->route[a+i] = ctx->seq[i];
+    thop_route_prefix( ctx, a > 0 ? a : 0, m );
+}
+
+static long int thop_window_bound( ls_context *ctx, long int a, long int b, long int delta )
+/*    
+      FUNCTION:       check whether a move that changes the length of the route between 
+                      positions a and b by delta can reduce the travel time
+      INPUT:          scratch space, positions, change of the length
+      OUTPUT:         TRUE if the move cannot reduce the travel time
+      COMMENTS:       all legs of the window are travelled at most at the speed with 
+                      which route[a] is left
+ */
+{
+    const double v = ( instance.max_speed - instance.min_speed ) / instance.capacity_of_knapsack;
+
+    return ( ctx->length[b] - ctx->length[a] + delta ) / ( instance.max_speed - v * ctx->weight_after[a] ) 
+        >= ctx->arrival[b] - ctx->arrival[a] - 1e-9;
+}
+
+static long int thop_route_moves( ls_context *ctx, long int m )
+/*    
+      FUNCTION:       first improvement 2-opt and or-opt moves on the route
+      INPUT:          scratch space holding the route, number of route cities
+      OUTPUT:         TRUE if the travel time was reduced
+      (SIDE)EFFECTS:  route is changed
+      COMMENTS:       the picked items stay the same, hence the weights carried before 
+                      and after the changed part of the route do not change and only 
+                      the travel time of that part has to be evaluated; moves that 
+                      fail thop_window_bound are not evaluated. Moves are restricted 
+                      to the nn_ls nearest neighbours of a city
+ */
+{
+    long int i, h, q, a, b, s, e, k, len, c, o;
+    long int improved = FALSE, found = TRUE;
+    long int *r = ctx->route;
+    double t;
+
+    while ( found ) {
+        found = FALSE;
+        /* 2-opt: make c2 the successor of c1 by reversing the route between them */
+        for ( i = 0 ; i <= m ; i++ ) {
+            for ( h = 0 ; h < nn_ls ; h++ ) {
+                q = ctx->route_pos[instance.nn_list[r[i]][h]];
+                if ( q < 0 )
+                    continue;
+                a = ( q < i ) ? q : i;
+                b = ( q < i ) ? i : q;
+                if ( b - a < 2 || b > m )
+                    continue;
+                if ( thop_window_bound( ctx, a, b + 1, instance.distance[r[a]][r[b]] + instance.distance[r[a+1]][r[b+1]]
+                                        - instance.distance[r[a]][r[a+1]] - instance.distance[r[b]][r[b+1]] ) )
+                    continue;
+                len = thop_window( ctx, a, b + 1 );
+                for ( k = 1 ; k <= b - a ; k++ ) {
+                    ctx->seq[k] = r[b+1-k];
+                    ctx->seq_weight[k] = ctx->city_weight[r[b+1-k]];
+                }
+                t = thop_window_arrival( ctx, a, len );
+                if ( t < ctx->arrival[b+1] - 1e-9 ) {
+                    thop_apply_window( ctx, a, len, m );
+                    found = TRUE;
+                }
+            }
+        }
+        /* or-opt: move a segment of up to three cities after a neighbour of its first city */
+        for ( s = 1 ; s <= m ; s++ ) {
+            for ( e = s ; e <= m && e < s + 3 ; e++ ) {
+                for ( h = 0 ; h < nn_ls ; h++ ) {
+                    k = ctx->route_pos[instance.nn_list[r[s]][h]];
+                    if ( k < 0 || k > m || ( k >= s - 1 && k <= e ) )
+                        continue;
+                    for ( o = 0 ; o < 2 ; o++ ) {  /* o = 1: segment is reversed */
+                        a = ( k < s ) ? k : s - 1;
+                        b = ( k < s ) ? e + 1 : k + 1;
+                        if ( thop_window_bound( ctx, a, b, instance.distance[r[s-1]][r[e+1]] 
+                                                + instance.distance[r[k]][o ? r[e] : r[s]] + instance.distance[o ? r[s] : r[e]][r[k+1]]
+                                                - instance.distance[r[s-1]][r[s]] - instance.distance[r[e]][r[e+1]] 
+                                                - instance.distance[r[k]][r[k+1]] ) )
+                            continue;
+                        len = 0;
+                        if ( k < s ) {
+                            ctx->seq[len++] = r[k];
+                            for ( i = s ; i <= e ; i++ )
+                                ctx->seq[len++] = o ? r[e+s-i] : r[i];
+                            for ( i = k + 1 ; i <= s - 1 ; i++ )
+                                ctx->seq[len++] = r[i];
+                            ctx->seq[len++] = r[e+1];
+                        } else {
+                            ctx->seq[len++] = r[s-1];
+                            for ( i = e + 1 ; i <= k ; i++ )
+                                ctx->seq[len++] = r[i];
+                            for ( i = s ; i <= e ; i++ )
+                                ctx->seq[len++] = o ? r[e+s-i] : r[i];
+                            ctx->seq[len++] = r[k+1];
+                        }
+                        for ( i = 0 ; i < len ; i++ ) {
+                            c = ctx->seq[i];
+                            ctx->seq_weight[i] = ( a + i == 0 ) ? 0 : ctx->city_weight[c];
+                        }
+                        t = thop_window_arrival( ctx, a, len );
+                        if ( t < ctx->arrival[b] - 1e-9 ) {
+                            thop_apply_window( ctx, a, len, m );
+                            found = TRUE;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        improved |= found;
+    }
+    return improved;
+}
+
+static void thop_pick_item( ant_struct *a, ls_context *ctx, long int j, long int sign )
+/*    
+      FUNCTION:       add (sign = 1) or remove (sign = -1) item j from the packing plan
+      INPUT:          ant, scratch space, item, sign
+      OUTPUT:         none
+      (SIDE)EFFECTS:  packing plan, city_weight and city_profit are updated
+ */
+{
+    if ( sign > 0 )
+        BITSET_SET(a->packing_plan, j);
+    else
+        BITSET_RESET(a->packing_plan, j);
+    ctx->city_weight[instance.item_city[j]] += sign * instance.item_weight[j];
+    ctx->city_profit[instance.item_city[j]] += sign * instance.item_profit[j];
+}
+
+static long int thop_remove_city( ant_struct *a, ls_context *ctx, long int k, long int m )
+/*    
+      FUNCTION:       drop the city at route position k and all items picked there
+      INPUT:          ant, scratch space, position, number of route cities
+      OUTPUT:         new number of route cities
+      (SIDE)EFFECTS:  route, packing plan and city data are updated; the prefix data 
+                      have to be recomputed by the caller from position k on
+ */
+{
+    long int i, j, c = ctx->route[k];
+
+    for ( j = instance.city_items[c] ; j < instance.city_items[c+1] ; j++ )
+        if ( BITSET_TEST(a->packing_plan, j) )
+            thop_pick_item( a, ctx, j, -1 );
+    for ( i = k ; i <= m ; i++ )
+        ctx->route[i] = ctx->route[i+1];
+    ctx->route_pos[c] = -1;
+    return m - 1;
+}
+
+static long int thop_insert_city( ls_context *ctx, long int c, long int k, long int m )
+/*    
+      FUNCTION:       insert city c after route position k
+      INPUT:          scratch space, city, position, number of route cities
+      OUTPUT:         new number of route cities
+      (SIDE)EFFECTS:  route is updated; the prefix data have to be recomputed by the 
+                      caller from position k on
+ */
+{
+    long int i;
+
+    for ( i = m + 1 ; i > k ; i-- )
+        ctx->route[i+1] = ctx->route[i];
+    ctx->route[k+1] = c;
+    return m + 1;
+}
+
+static double thop_add_arrival( ls_context *ctx, long int c, long int k, long int drop, 
+                                long int w, long int m )
+/*    
+      FUNCTION:       arrival time at the end city if weight w is picked at city c, 
+                      inserting c after route position k if it is not on the route, 
+                      and the city at route position drop is skipped (drop = -1: none)
+      INPUT:          scratch space, city, positions, weight, number of route cities
+      OUTPUT:         arrival time at the end city
+      (SIDE)EFFECTS:  seq and seq_weight are overwritten
+ */
+{
+    long int i, a, len = 0, p = ctx->route_pos[c];
+
+    a = ( p >= 0 ) ? p : k;
+    if ( drop >= 0 && drop - 1 < a )
+        a = drop - 1;
+    for ( i = a ; i <= m + 1 ; i++ ) {
+        if ( i == drop )
+            continue;
+        ctx->seq[len] = ctx->route[i];
+        ctx->seq_weight[len++] = ( i == 0 ) ? 0 : ctx->city_weight[ctx->route[i]] + ( i == p ) * w;
+        if ( p < 0 && i == k ) {
+            ctx->seq[len] = c;
+            ctx->seq_weight[len++] = w;
+        }
+    }
+    return thop_window_arrival( ctx, a, len );
+}
+
+static long int thop_item_moves( ant_struct *a, ls_context *ctx, long int *m, long int *profit, long int *weight )
+/*    
+      FUNCTION:       add items to the packing plan, possibly dropping the items of a 
+                      city with less profit
+      INPUT:          ant, scratch space, pointers to the number of route cities and 
+                      to the total profit and weight of the packing plan
+      OUTPUT:         TRUE if the profit was increased
+      (SIDE)EFFECTS:  packing plan, route and route data are changed
+      COMMENTS:       an item of a city that is not on the route is inserted after 
+                      the route city among the nn_ls nearest neighbours of its city 
+                      that gives the earliest arrival. If the item does not fit, a 
+                      route city among these neighbours with less profit is dropped 
+                      and, if needed, replaced by the city of the item
+ */
+{
+    long int l, j, c, h, k, p, q, best_k, w;
+    long int improved = FALSE;
+    double t, best_t, s, end;
+    const double v = ( instance.max_speed - instance.min_speed ) / instance.capacity_of_knapsack;
+
+    for ( l = 0 ; l < n_thop_items ; l++ ) {
+        j = thop_item_order[l];
+        if ( BITSET_TEST(a->packing_plan, j) )
+            continue;
+        c = instance.item_city[j];
+        w = instance.item_weight[j];
+        best_k = -1; q = -1;
+        end = ctx->arrival[*m+1];
+
+        /* plain insertion */
+        if ( *weight + w <= instance.capacity_of_knapsack ) {
+            if ( (p = ctx->route_pos[c]) >= 0 ) {
+                if ( end + w * ( ctx->slope[*m+1] - ctx->slope[p] ) <= instance.max_time ) {
+                    t = thop_add_arrival( ctx, c, -1, -1, w, *m );
+                    if ( t - EPSILON <= instance.max_time )
+                        best_k = p;
+                }
+            } else {
+                best_t = instance.max_time + 1.;
+                for ( h = 0 ; h < nn_ls ; h++ ) {
+                    k = ctx->route_pos[instance.nn_list[c][h]];
+                    if ( k < 0 )
+                        continue;
+                    if ( k == *m + 1 )
+                        k--;             /* insert before the end city */
+                    /* lower bound: exact time of the two new legs, slope for the rest */
+                    s = instance.max_speed - v * ctx->weight_after[k];
+                    t = end - ( ctx->arrival[k+1] - ctx->arrival[k] ) 
+                        + instance.distance[ctx->route[k]][c] / s 
+                        + instance.distance[c][ctx->route[k+1]] / ( s - v * w )
+                        + w * ( ctx->slope[*m+1] - ctx->slope[k+1] );
+                    if ( t > instance.max_time || t >= best_t )
+                        continue;
+                    t = thop_add_arrival( ctx, c, k, -1, w, *m );
+                    if ( t - EPSILON <= instance.max_time && t < best_t ) {
+                        best_t = t; best_k = k;
+                    }
+                }
+            }
+        }
+        /* drop a neighbouring route city with less profit */
+        for ( h = 0 ; best_k < 0 && h < nn_ls ; h++ ) {
+            q = ctx->route_pos[instance.nn_list[c][h]];
+            if ( q <= 0 || q > *m || ctx->city_profit[ctx->route[q]] >= instance.item_profit[j] ||
+                 *weight - ctx->city_weight[ctx->route[q]] + w > instance.capacity_of_knapsack ) {
+                q = -1;
+                continue;
+            }
+            /* lower bound: exact time of the shortcut, slope for the weight dropped 
+               at route[q] and for the additional weight behind route[q] */
+            p = ctx->route_pos[c] > q ? ctx->route_pos[c] : q + 1;
+            t = end - ( ctx->arrival[q+1] - ctx->arrival[q-1] ) 
+                + instance.distance[ctx->route[q-1]][ctx->route[q+1]] / ( instance.max_speed - v * ctx->weight_after[q-1] )
+                - ctx->city_weight[ctx->route[q]] * ( ctx->slope[*m+1] - ctx->slope[q+1] )
+                + w * ( ctx->slope[*m+1] - ctx->slope[p] );
+            if ( t > instance.max_time ) {
+                q = -1;
+                continue;
+            }
+            t = thop_add_arrival( ctx, c, q - 1, q, w, *m );
+            if ( t - EPSILON <= instance.max_time )
+                best_k = ( ctx->route_pos[c] >= 0 ) ? ctx->route_pos[c] : q - 1;
+            else
+                q = -1;
+        }
+        if ( best_k < 0 )
+            continue;
+
+        /* apply the move */
+        k = best_k;
+        if ( q >= 0 ) {
+            *profit -= ctx->city_profit[ctx->route[q]];
+            *weight -= ctx->city_weight[ctx->route[q]];
+            *m = thop_remove_city( a, ctx, q, *m );
+            if ( best_k >= q )
+                best_k--;
+            if ( q - 1 < k )
+                k = q - 1;
+        }
+        if ( ctx->route_pos[c] < 0 )
+            *m = thop_insert_city( ctx, c, best_k, *m );
+        thop_pick_item( a, ctx, j, 1 );
+        *profit += instance.item_profit[j];
+        *weight += w;
+        thop_route_prefix( ctx, k, *m );
+        improved = TRUE;
+    }
+    return improved;
+}
+
+void thop_local_search( ant_struct *a, ls_context *ctx )
+/*    
+      FUNCTION:       ThOP local search of the solution of an ant
+      INPUT:          pointer to the ant, scratch space of the local search
+      OUTPUT:         none
+      (SIDE)EFFECTS:  tour, packing plan, n_constructed and fitness of the ant are 
+                      changed; the fitness never gets worse
+      COMMENTS:       the route consists of city 0, the cities of the constructed 
+                      tour at which items are picked and the end city. 2-opt and 
+                      or-opt moves reduce its travel time, which is evaluated for the 
+                      changed part only using the carried weights and arrival times 
+                      kept for each route position. Then items are added greedily by 
+                      decreasing profit / weight, see thop_item_moves. Both steps are 
+                      repeated until no move improves. The route becomes the 
+                      constructed part of the tour, the other cities are appended
+ */
+{
+    long int i, j, c, m, len;
+    long int profit = 0, weight = 0;
+    long int *r = ctx->route;
+
+    for ( c = 0 ; c < instance.n ; c++ ) {
+        ctx->city_weight[c] = ctx->city_profit[c] = 0;
+        ctx->route_pos[c] = -1;
+    }
+    for ( j = 0 ; j < instance.m ; j++ ) {
+        if ( BITSET_TEST(a->packing_plan, j) ) {
+            ctx->city_weight[instance.item_city[j]] += instance.item_weight[j];
+            ctx->city_profit[instance.item_city[j]] += instance.item_profit[j];
+            profit += instance.item_profit[j];
+            weight += instance.item_weight[j];
+        }
+    }
+    m = 0;
+    r[0] = a->tour[0];
+    for ( i = 1 ; i <= a->n_constructed ; i++ )
+        if ( ctx->city_weight[a->tour[i]] > 0 )
+            r[++m] = a->tour[i];
+    r[m+1] = instance.n - 2;
+    thop_route_prefix( ctx, 0, m );
+
+    thop_route_moves( ctx, m );
+    while ( thop_item_moves( a, ctx, &m, &profit, &weight ) ) {
+        thop_route_moves( ctx, m );
+    }
+
+    /* route first, then the remaining cities in their previous order */
+    len = 0;
+    for ( i = 1 ; i <= instance.n - 3 ; i++ )
+        if ( ctx->route_pos[a->tour[i]] < 0 )
+            ctx->seq[len++] = a->tour[i];
+    for ( i = 1 ; i <= m ; i++ )
+        a->tour[i] = r[i];
+    for ( i = 0 ; i < len ; i++ )
+        a->tour[m+1+i] = ctx->seq[i];
+    DEBUG( assert ( m + len == instance.n - 3 ); )
+    a->n_constructed = m;
+    a->fitness = instance.UB + 1 - profit;
 }
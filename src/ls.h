@@ -50,14 +50,90 @@
 
  ***************************************************************************/
 
+#define PREFIX_MARGIN    10     /* cities after the active prefix of a ThOP tour that may enter it */
+
+#define LS_ALL           0      /* local search policies: search all ants */
+#define LS_TOP_K         1      /* the ls_ants best ants */
+#define LS_RANK          2      /* each ant with a probability proportional to its inverse rank */
+#define LS_BUDGET        3      /* the ants in order of fitness until ls_budget is spent */
+
+typedef struct {
+    long int  *pos;            /* positions of cities in tour */
+    long int  *dlb;            /* vector containing don't look bits */
+    long int  *random_vector;  /* order in which the cities are scanned */
+    long int  *h_tour;         /* help vectors for performing 3-opt exchange moves */
+    long int  *hh_tour;
+    long int  *rng;            /* state of the random number generator */
+    long int  *route;          /* ThOP local search: city 0, the cities with picked items, end city */
+    long int  *route_pos;      /* position of each city in route, -1 if not on the route */
+    long int  *city_weight;    /* weight of the items picked at each city */
+    long int  *city_profit;    /* profit of the items picked at each city */
+    long int  *weight_after;   /* weight carried when leaving route[i] */
+    long int  *length;         /* length of the route up to route[i] */
+    double    *arrival;        /* arrival time at route[i] */
+    double    *slope;          /* bound on the delay per unit of weight, see thop_route_prefix */
+    long int  *seq;            /* cities of a candidate move */
+    long int  *seq_weight;     /* weight picked at each city of seq */
+    long int  *prefix_tour;    /* active prefix of a ThOP tour, closed by the end and dummy city */
+    long int  *scan_stamp;     /* scan_stamp[c] == scan_epoch if c is among the cities to scan */
+    long int  scan_epoch;      /* incremented by each local search call */
+    long int  n_scan;          /* number of cities to scan, the first entries of random_vector */
+} ls_context;
+
+extern ls_context **ls_workspaces;
+
+extern long int n_ls_workspaces;
+
+extern long int *ls_reference;
+
+extern long int *ls_reference_pos;
+
+extern long int *thop_item_order;
+
+extern long int n_thop_items;
+
 extern long int ls_flag;
 
 extern long int nn_ls; 
 
 extern long int dlb_flag; 
 
-void two_opt_first( long int *tour, long int n );
+extern long int ls_policy;
+
+extern long int ls_ants;
+
+extern double   ls_budget;
+
+extern long int ls_calls;
+
+extern long int ls_improved;
+
+extern long int ls_gain;
+
+extern double   ls_time;
+
+ls_context * allocate_ls_context( long int n );
+
+void free_ls_context( ls_context *ctx );
+
+void allocate_ls_workspaces( long int n_workers );
+
+void free_ls_workspaces( void );
+
+void set_ls_reference( long int *tour );
+
+void random_permutation( long int *r, long int n, long int *idum );
+
+void two_opt_first( long int *tour, long int n, ls_context *ctx );
+
+void two_h_opt_first( long int *tour, long int n, ls_context *ctx );
+
+void three_opt_first( long int *tour, long int n, ls_context *ctx );
+
+long int active_prefix( ant_struct *a );
+
+void prefix_local_search( ant_struct *a, ls_context *ctx );
 
-void two_h_opt_first( long int *tour, long int n );
+void init_thop_item_order( void );
 
-void three_opt_first( long int *tour, long int n );
+void thop_local_search( ant_struct *a, ls_context *ctx );
@@ -10,6 +10,7 @@
 #include "utilities.h"
 #include "ants.h"
 #include "ls.h"
+#include "timer.h"
 
 
 #ifndef STR_ERR_UNKNOWN_LONG_OPT
@@ -37,7 +38,7 @@
 #endif
 
 #define STR_HELP_INPUTFILE \
-        "  -i, --inputfile       inputfile (ThOP format necessary)\n"
+        "  -i, --inputfile       inputfile (ThOP format or compiled by thop-compile)\n"
         
 #define STR_HELP_OUTPUTFILE \
         "  -o, --outputfile      outputfile\n"
@@ -48,6 +49,9 @@
 #define STR_HELP_TOURS \
         "  -s, --tours           number of steps in each trial\n"
         
+#define STR_HELP_EVALUATIONS \
+        "      --evaluations     number of packing plan evaluations in each trial, replaces --tours and --time\n"
+
 #define STR_HELP_PACKING_TRIES \
         "  -p, --ptries          number of tries to construct a packing plan from a give tour\n"
 
@@ -88,10 +92,19 @@
         "  -k, --nnls            number of nearest neighbors for local search\n"
 
 #define STR_HELP_LOCALSEARCH \
-        "  -l, --localsearch     0: no local search   1: 2-opt   2: 2.5-opt   3: 3-opt\n"
+        "  -l, --localsearch     0: no local search   1: 2-opt   2: 2.5-opt   3: 3-opt   4: ThOP local search\n"
 
 #define STR_HELP_DLB \
-        "  -d, --dlb             1 use don't look bits in local search\n"
+        "  -d, --dlb             1 use don't look bits in local search   2 start only at arcs not in the best-so-far tour\n"
+
+#define STR_HELP_LSPOLICY \
+        "      --lspolicy        ants searched per iteration, 0: all   1: the best --lsants   2: by rank   3: until --lsbudget is spent\n"
+
+#define STR_HELP_LSANTS \
+        "      --lsants          number of ants searched by --lspolicy 1, expected number for --lspolicy 2\n"
+
+#define STR_HELP_LSBUDGET \
+        "      --lsbudget        wall-clock seconds of local search per iteration for --lspolicy 3\n"
 
 #define STR_HELP_AS \
         "  -u, --as              apply basic Ant System\n"
@@ -111,6 +124,39 @@
 #define STR_HELP_ACS \
         "  -z, --acs             apply ant colony system\n"
 
+#define STR_HELP_DEFERRED \
+        "      --deferred        apply the local pheromone updates of ACS at the end of each construction step\n"
+
+#define STR_HELP_PACO \
+        "      --paco            apply population-based ant colony optimization\n"
+
+#define STR_HELP_POPSIZE \
+        "      --popsize         number of solutions in the population of --paco\n"
+
+#define STR_HELP_REDUCE \
+        "      --reduce          skip tour construction for cities that cannot be visited within the time limit\n"
+
+#define STR_HELP_CANDIDATES \
+        "      --candidates      candidate lists, 0: nearest neighbours   1: quadrant neighbours   2: alpha-nearness\n"
+
+#define STR_HELP_CANDCACHE \
+        "      --candcache       file that keeps quadrant and alpha-nearness candidate lists for later runs\n"
+
+#define STR_HELP_RESTARTDIST \
+        "      --restartdist     MMAS also restarts if two tours differ on average in less than this fraction of the arcs\n"
+
+#define STR_HELP_CLOCK \
+        "      --clock           clock of --time, 0: CPU time of the process   1: wall-clock time   2: CPU time of the main thread\n"
+
+#define STR_HELP_CHECKPOINT \
+        "      --checkpoint      save the state of the run to <outputfile>.ckpt every this many seconds (wall-clock)\n"
+
+#define STR_HELP_RESUME \
+        "      --resume          continue the run saved in <outputfile>.ckpt, if it exists\n"
+
+#define STR_HELP_PARTIAL \
+        "      --partial         stop tour construction once no city can be reached within the time limit at maximum speed along the tour (a heuristic cutoff)\n"
+
 #define STR_HELP_LOG \
         "      --log             save an extra file (<outputfile>.log) with log messages\n"
 
@@ -122,8 +168,10 @@ static const char *const STR_HELP[] = {
         STR_HELP_OUTPUTFILE ,        
         STR_HELP_TRIES ,
         STR_HELP_TOURS ,
+        STR_HELP_EVALUATIONS ,
         STR_HELP_PACKING_TRIES ,
         STR_HELP_TIME ,
+        STR_HELP_CLOCK ,
         STR_HELP_OPTIMUM ,
         STR_HELP_ANTS ,
         STR_HELP_NNANTS ,
@@ -136,13 +184,26 @@ static const char *const STR_HELP[] = {
         STR_HELP_NNLS ,
         STR_HELP_LOCALSEARCH ,
         STR_HELP_DLB ,
+        STR_HELP_LSPOLICY ,
+        STR_HELP_LSANTS ,
+        STR_HELP_LSBUDGET ,
+        STR_HELP_CANDIDATES ,
+        STR_HELP_CANDCACHE ,
+        STR_HELP_RESTARTDIST ,
+        STR_HELP_CHECKPOINT ,
+        STR_HELP_RESUME ,
         STR_HELP_AS ,
         STR_HELP_EAS ,
         STR_HELP_RAS ,
         STR_HELP_MMAS ,
         STR_HELP_BWAS ,
         STR_HELP_ACS ,        
+        STR_HELP_DEFERRED ,
+        STR_HELP_PACO ,
+        STR_HELP_POPSIZE ,
         STR_HELP_SEED ,        
+        STR_HELP_REDUCE ,
+        STR_HELP_PARTIAL ,
         STR_HELP_LOG ,
         STR_HELP_HELP,
         NULL
@@ -207,6 +268,36 @@ struct options {
     /* Set to 1 if option --dlb (-d) has been specified.  */
     unsigned int opt_dlb : 1;
 
+    /* Set to 1 if option --lspolicy has been specified.  */
+    unsigned int opt_lspolicy : 1;
+
+    /* Set to 1 if option --lsants has been specified.  */
+    unsigned int opt_lsants : 1;
+
+    /* Set to 1 if option --lsbudget has been specified.  */
+    unsigned int opt_lsbudget : 1;
+
+    /* Set to 1 if option --candidates has been specified.  */
+    unsigned int opt_candidates : 1;
+
+    /* Set to 1 if option --candcache has been specified.  */
+    unsigned int opt_candcache : 1;
+
+    /* Set to 1 if option --restartdist has been specified.  */
+    unsigned int opt_restartdist : 1;
+
+    /* Set to 1 if option --clock has been specified.  */
+    unsigned int opt_clock : 1;
+
+    /* Set to 1 if option --evaluations has been specified.  */
+    unsigned int opt_evaluations : 1;
+
+    /* Set to 1 if option --checkpoint has been specified.  */
+    unsigned int opt_checkpoint : 1;
+
+    /* Set to 1 if option --resume has been specified.  */
+    unsigned int opt_resume : 1;
+
     /* Set to 1 if option --as (-u) has been specified.  */
     unsigned int opt_as : 1;
 
@@ -225,6 +316,21 @@ struct options {
     /* Set to 1 if option --acs (-z) has been specified.  */
     unsigned int opt_acs : 1;
 
+    /* Set to 1 if option --deferred has been specified.  */
+    unsigned int opt_deferred : 1;
+
+    /* Set to 1 if option --paco has been specified.  */
+    unsigned int opt_paco : 1;
+
+    /* Set to 1 if option --popsize has been specified.  */
+    unsigned int opt_popsize : 1;
+
+    /* Set to 1 if option --reduce has been specified.  */
+    unsigned int opt_reduce : 1;
+
+    /* Set to 1 if option --partial has been specified.  */
+    unsigned int opt_partial : 1;
+
     /* Set to 1 if option --log has been specified.  */
     unsigned int opt_log : 1;
 
@@ -282,6 +388,9 @@ struct options {
     /* Argument to option --rasranks (-f).  */
     const char *arg_rasranks;
 
+    /* Argument to option --popsize.  */
+    const char *arg_popsize;
+
     /* Argument to option --nnls (-k).  */
     const char *arg_nnls;
 
@@ -291,6 +400,33 @@ struct options {
     /* Argument to option --dlb (-d).  */
     const char *arg_dlb;
 
+    /* Argument to option --lspolicy.  */
+    const char *arg_lspolicy;
+
+    /* Argument to option --lsants.  */
+    const char *arg_lsants;
+
+    /* Argument to option --lsbudget.  */
+    const char *arg_lsbudget;
+
+    /* Argument to option --candidates.  */
+    const char *arg_candidates;
+
+    /* Argument to option --candcache.  */
+    const char *arg_candcache;
+
+    /* Argument to option --restartdist.  */
+    const char *arg_restartdist;
+
+    /* Argument to option --clock.  */
+    const char *arg_clock;
+
+    /* Argument to option --evaluations.  */
+    const char *arg_evaluations;
+
+    /* Argument to option --checkpoint.  */
+    const char *arg_checkpoint;
+
 };
 
 /* Parse command line options.  Return index of first non-option argument,
@@ -318,15 +454,30 @@ parse_options (struct options *const options, const char *const program_name,
     static const char *const optstr__nnls = "nnls";
     static const char *const optstr__localsearch = "localsearch";
     static const char *const optstr__dlb = "dlb";
+    static const char *const optstr__lspolicy = "lspolicy";
+    static const char *const optstr__lsants = "lsants";
+    static const char *const optstr__lsbudget = "lsbudget";
     static const char *const optstr__as = "as";
     static const char *const optstr__eas = "eas";
     static const char *const optstr__ras = "ras";
     static const char *const optstr__mmas = "mmas";
     static const char *const optstr__bwas = "bwas";
     static const char *const optstr__acs = "acs";
+    static const char *const optstr__deferred = "deferred";
+    static const char *const optstr__paco = "paco";
+    static const char *const optstr__popsize = "popsize";
+    static const char *const optstr__reduce = "reduce";
+    static const char *const optstr__partial = "partial";
     static const char *const optstr__log = "log";
     static const char *const optstr__help = "help";
     static const char *const optstr__calibration = "calibration";
+    static const char *const optstr__candidates = "candidates";
+    static const char *const optstr__candcache = "candcache";
+    static const char *const optstr__restartdist = "restartdist";
+    static const char *const optstr__clock = "clock";
+    static const char *const optstr__evaluations = "evaluations";
+    static const char *const optstr__checkpoint = "checkpoint";
+    static const char *const optstr__resume = "resume";
     int i = 0;    
     options->opt_inputfile = 0;
     options->opt_outputfile = 0;
@@ -347,15 +498,30 @@ parse_options (struct options *const options, const char *const program_name,
     options->opt_nnls = 0;
     options->opt_localsearch = 0;
     options->opt_dlb = 0;
+    options->opt_lspolicy = 0;
+    options->opt_lsants = 0;
+    options->opt_lsbudget = 0;
     options->opt_as = 0;
     options->opt_eas = 0;
     options->opt_ras = 0;
     options->opt_mmas = 0;
     options->opt_bwas = 0;
     options->opt_acs = 0;
+    options->opt_deferred = 0;
+    options->opt_paco = 0;
+    options->opt_popsize = 0;
+    options->opt_reduce = 0;
+    options->opt_partial = 0;
     options->opt_log = 0;
     options->opt_help = 0;
     options->opt_calibration = 0;  
+    options->opt_candidates = 0;
+    options->opt_candcache = 0;
+    options->opt_restartdist = 0;
+    options->opt_clock = 0;
+    options->opt_evaluations = 0;
+    options->opt_checkpoint = 0;
+    options->opt_resume = 0;
     options->arg_inputfile = 0;
     options->arg_outputfile = 0;
     options->arg_tries = 0;
@@ -372,9 +538,19 @@ parse_options (struct options *const options, const char *const program_name,
     options->arg_q0 = 0;
     options->arg_elitistants = 0;
     options->arg_rasranks = 0;
+    options->arg_popsize = 0;
     options->arg_nnls = 0;
     options->arg_localsearch = 0;
     options->arg_dlb = 0;
+    options->arg_lspolicy = 0;
+    options->arg_lsants = 0;
+    options->arg_lsbudget = 0;
+    options->arg_candidates = 0;
+    options->arg_candcache = 0;
+    options->arg_restartdist = 0;
+    options->arg_clock = 0;
+    options->arg_evaluations = 0;
+    options->arg_checkpoint = 0;
     while (++i < argc)
     {
         const char *option = argv [i];
@@ -488,6 +664,8 @@ parse_options (struct options *const options, const char *const program_name,
             case 'c':
                 if (strncmp (option + 1, optstr__calibration + 1, option_len - 1) == 0)
                 {
+                    if (option_len <= 2)
+                        goto error_long_opt_ambiguous;
                     if (argument != 0)
                     {
                         option = optstr__calibration;
@@ -496,10 +674,76 @@ parse_options (struct options *const options, const char *const program_name,
                     options->opt_calibration = 1;
                     break;
                 }
+                else if (strncmp (option + 1, optstr__clock + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 1)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                        options->arg_clock = argument;
+                    else if (++i < argc)
+                        options->arg_clock = argv [i];
+                    else
+                    {
+                        option = optstr__clock;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_clock = 1;
+                    break;
+                }
+                else if (strncmp (option + 1, optstr__checkpoint + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 1)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                        options->arg_checkpoint = argument;
+                    else if (++i < argc)
+                        options->arg_checkpoint = argv [i];
+                    else
+                    {
+                        option = optstr__checkpoint;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_checkpoint = 1;
+                    break;
+                }
+                else if (strncmp (option + 1, optstr__candcache + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 4)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                        options->arg_candcache = argument;
+                    else if (++i < argc)
+                        options->arg_candcache = argv [i];
+                    else
+                    {
+                        option = optstr__candcache;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_candcache = 1;
+                    break;
+                }
+                else if (strncmp (option + 1, optstr__candidates + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 4)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                        options->arg_candidates = argument;
+                    else if (++i < argc)
+                        options->arg_candidates = argv [i];
+                    else
+                    {
+                        option = optstr__candidates;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_candidates = 1;
+                    break;
+                }
                 goto error_unknown_long_opt;
             case 'd':
                 if (strncmp (option + 1, optstr__dlb + 1, option_len - 1) == 0)
                 {
+                    if (option_len <= 1)
+                        goto error_long_opt_ambiguous;
                     if (argument != 0)
                         options->arg_dlb = argument;
                     else if (++i < argc)
@@ -512,6 +756,18 @@ parse_options (struct options *const options, const char *const program_name,
                     options->opt_dlb = 1;
                     break;
                 }
+                else if (strncmp (option + 1, optstr__deferred + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 1)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                    {
+                        option = optstr__deferred;
+                        goto error_unexpec_arg_long;
+                    }
+                    options->opt_deferred = 1;
+                    break;
+                }
                 goto error_unknown_long_opt;
             case 'e':
                 if (strncmp (option + 1, optstr__eas + 1, option_len - 1) == 0)
@@ -542,6 +798,22 @@ parse_options (struct options *const options, const char *const program_name,
                     options->opt_elitistants = 1;
                     break;
                 }
+                else if (strncmp (option + 1, optstr__evaluations + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 1)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                        options->arg_evaluations = argument;
+                    else if (++i < argc)
+                        options->arg_evaluations = argv [i];
+                    else
+                    {
+                        option = optstr__evaluations;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_evaluations = 1;
+                    break;
+                }
                 goto error_unknown_long_opt;
             case 'h':
                 if (strncmp (option + 1, optstr__help + 1, option_len - 1) == 0)
@@ -598,6 +870,54 @@ parse_options (struct options *const options, const char *const program_name,
                     options->opt_log = 1;
                     break;
                 }
+                else if (strncmp (option + 1, optstr__lspolicy + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 2)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                        options->arg_lspolicy = argument;
+                    else if (++i < argc)
+                        options->arg_lspolicy = argv [i];
+                    else
+                    {
+                        option = optstr__lspolicy;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_lspolicy = 1;
+                    break;
+                }
+                else if (strncmp (option + 1, optstr__lsants + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 2)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                        options->arg_lsants = argument;
+                    else if (++i < argc)
+                        options->arg_lsants = argv [i];
+                    else
+                    {
+                        option = optstr__lsants;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_lsants = 1;
+                    break;
+                }
+                else if (strncmp (option + 1, optstr__lsbudget + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 2)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                        options->arg_lsbudget = argument;
+                    else if (++i < argc)
+                        options->arg_lsbudget = argv [i];
+                    else
+                    {
+                        option = optstr__lsbudget;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_lsbudget = 1;
+                    break;
+                }
                 goto error_unknown_long_opt;
             case 'm':
                 if (strncmp (option + 1, optstr__mmas + 1, option_len - 1) == 0)
@@ -662,6 +982,44 @@ parse_options (struct options *const options, const char *const program_name,
                     options->opt_ptries = 1;
                     break;
                 }
+                else if (strncmp (option + 1, optstr__partial + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 2)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                    {
+                        option = optstr__partial;
+                        goto error_unexpec_arg_long;
+                    }
+                    options->opt_partial = 1;
+                    break;
+                }
+                else if (strncmp (option + 1, optstr__paco + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 2)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                    {
+                        option = optstr__paco;
+                        goto error_unexpec_arg_long;
+                    }
+                    options->opt_paco = 1;
+                    break;
+                }
+                else if (strncmp (option + 1, optstr__popsize + 1, option_len - 1) == 0)
+                {
+                    if (argument != 0)
+                        options->arg_popsize = argument;
+                    else if (++i < argc)
+                        options->arg_popsize = argv [i];
+                    else
+                    {
+                        option = optstr__popsize;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_popsize = 1;
+                    break;
+                }
                 goto error_unknown_long_opt;
             case 'o':
                 if (strncmp (option + 1, optstr__outputfile + 1, option_len - 1) == 0)
@@ -756,6 +1114,46 @@ parse_options (struct options *const options, const char *const program_name,
                     options->opt_rho = 1;
                     break;
                 }
+                else if (strncmp (option + 1, optstr__reduce + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 2)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                    {
+                        option = optstr__reduce;
+                        goto error_unexpec_arg_long;
+                    }
+                    options->opt_reduce = 1;
+                    break;
+                }
+                else if (strncmp (option + 1, optstr__restartdist + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 3)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                        options->arg_restartdist = argument;
+                    else if (++i < argc)
+                        options->arg_restartdist = argv [i];
+                    else
+                    {
+                        option = optstr__restartdist;
+                        goto error_missing_arg_long;
+                    }
+                    options->opt_restartdist = 1;
+                    break;
+                }
+                else if (strncmp (option + 1, optstr__resume + 1, option_len - 1) == 0)
+                {
+                    if (option_len <= 3)
+                        goto error_long_opt_ambiguous;
+                    if (argument != 0)
+                    {
+                        option = optstr__resume;
+                        goto error_unexpec_arg_long;
+                    }
+                    options->opt_resume = 1;
+                    break;
+                }
                 goto error_unknown_long_opt;
             case 's':
                 if (strncmp (option + 1, optstr__seed + 1, option_len - 1) == 0)
@@ -1110,6 +1508,12 @@ int parse_commandline (int argc, char *argv [])
 
     log_flag = !options.opt_log;
 
+    reduce_flag = options.opt_reduce;
+
+    partial_flag = options.opt_partial;
+
+    acs_deferred_flag = options.opt_deferred;
+
     if ( options.opt_time ) {
         max_time = atof(options.arg_time);
         /*
@@ -1155,6 +1559,11 @@ int parse_commandline (int argc, char *argv [])
     }
     */
 
+    if ( options.opt_evaluations ) {
+        max_evaluations = atol(options.arg_evaluations);
+        check_out_of_range( max_evaluations, 1, LONG_MAX, "max_evaluations (evaluations)");
+    }
+
     if ( options.opt_seed ) {
         seed = atol(options.arg_seed);
         /*
@@ -1237,12 +1646,12 @@ int parse_commandline (int argc, char *argv [])
     }
 
     if (options.opt_as + options.opt_eas + options.opt_ras + options.opt_mmas
-            + options.opt_bwas + options.opt_acs > 1) {
+            + options.opt_bwas + options.opt_acs + options.opt_paco > 1) {
         fprintf (stderr, "error: more than one ACO algorithm enabled in the command line");
         exit (1);
     } else if (options.opt_as + options.opt_eas + options.opt_ras + options.opt_mmas
-            + options.opt_bwas + options.opt_acs == 1)  {
-        as_flag = eas_flag = ras_flag = mmas_flag = bwas_flag = acs_flag = FALSE;
+            + options.opt_bwas + options.opt_acs + options.opt_paco == 1)  {
+        as_flag = eas_flag = ras_flag = mmas_flag = bwas_flag = acs_flag = paco_flag = FALSE;
     }
 
     if (options.opt_as || as_flag) {
@@ -1281,6 +1690,11 @@ int parse_commandline (int argc, char *argv [])
         /*fprintf(stdout,"acs_flag is set to 1, run Ant Colony System\n");*/
     }
 
+    if ( options.opt_paco || paco_flag ) {
+        paco_flag = TRUE;
+        set_default_paco_parameters();
+    }
+
     if ( options.opt_localsearch ) {
         ls_flag = atol(options.arg_localsearch);
         /*
@@ -1288,8 +1702,7 @@ int parse_commandline (int argc, char *argv [])
         if (options.arg_localsearch != NULL)
             printf ("with argument \"%ld\"\n", ls_flag);
         */
-        if ( ls_flag != 0 ) printf("Error: there is no local search defined for the ThOP in this code version.\n");
-        check_out_of_range(ls_flag, 0, 0, "ls_flag");
+        check_out_of_range(ls_flag, 0, 4, "ls_flag");
     } 
     /*
     else {
@@ -1463,6 +1876,11 @@ int parse_commandline (int argc, char *argv [])
     }
     */
 
+    if ( options.opt_popsize ) {
+        paco_size = atol(options.arg_popsize);
+        check_out_of_range( paco_size, 1, MAX_ANTS, "popsize");
+    } 
+
     if ( options.opt_nnls ) {
         nn_ls = atol(options.arg_nnls);
         /*
@@ -1485,7 +1903,7 @@ int parse_commandline (int argc, char *argv [])
         if (options.arg_dlb != NULL)
             printf ("with argument \"%ld\"\n", dlb_flag);
         */
-        check_out_of_range( dlb_flag, 0, 1, "dlb_flag");
+        check_out_of_range( dlb_flag, 0, 2, "dlb_flag");
     } 
     /*
     else {
@@ -1493,6 +1911,58 @@ int parse_commandline (int argc, char *argv [])
                 dlb_flag ? 1 : 0, dlb_flag ? "use" : "not use");
     }
     */
+
+    if ( options.opt_lspolicy ) {
+        ls_policy = atol(options.arg_lspolicy);
+        check_out_of_range( ls_policy, LS_ALL, LS_BUDGET, "lspolicy");
+    }
+
+    if ( options.opt_lsants ) {
+        ls_ants = atol(options.arg_lsants);
+        check_out_of_range( ls_ants, 1, MAX_ANTS, "lsants");
+    }
+
+    if ( options.opt_lsbudget ) {
+        ls_budget = atof(options.arg_lsbudget);
+        check_out_of_range( ls_budget, 0.0, 86400., "lsbudget (seconds)");
+    }
+
+    if ( options.opt_candidates ) {
+        candidate_flag = atol(options.arg_candidates);
+        check_out_of_range( candidate_flag, CAND_NEAREST, CAND_ALPHA, "candidates");
+    }
+
+    if ( options.opt_candcache ) {
+        if (strlen(options.arg_candcache) >= LINE_BUF_LEN) {
+            fprintf (stderr, "error: too long candidate cache filename '%s', maximum length is %d", options.arg_candcache, LINE_BUF_LEN);
+            exit (1);
+        }
+        strcpy (candidate_cache_name, options.arg_candcache);
+    }
+
+    if ( options.opt_clock ) {
+        long int clock_flag = atol(options.arg_clock);
+
+        check_out_of_range( clock_flag, 0, 2, "clock");
+        budget_timer = clock_flag == 1 ? REAL : ( clock_flag == 2 ? THREAD : VIRTUAL );
+    }
+
+    resume_flag = options.opt_resume;
+
+    if ( options.opt_checkpoint ) {
+        checkpoint_period = atof(options.arg_checkpoint);
+        check_out_of_range( checkpoint_period, 0.0, 86400., "checkpoint (seconds)");
+    }
+
+    if ( ( resume_flag || checkpoint_period > 0. ) && !output_flag ) {
+        fprintf(stderr, "error: --checkpoint and --resume require --outputfile\n");
+        exit(1);
+    }
+
+    if ( options.opt_restartdist ) {
+        restart_distance = atof(options.arg_restartdist);
+        check_out_of_range( restart_distance, 0.0, 1.0, "restartdist");
+    }
     
     /*puts ("Non-option arguments:");*/
 
@@ -56,6 +56,7 @@
 #include <math.h>
 #include <limits.h>
 #include <assert.h>
+#include <string.h>
 
 #include "inout.h"
 #include "thop.h"
@@ -185,11 +186,14 @@ long int** compute_distances(void)
       FUNCTION: computes the matrix of all intercity distances
       INPUT:    none
       OUTPUT:   pointer to distance matrix, has to be freed when program stops
+      COMMENTS: the matrix of a compiled instance is used as it is
  */
 {
     long int     i, j;
     long int     **matrix;
 
+    if ( (matrix = compiled_distances()) != NULL )
+        return matrix;
     if((matrix = malloc(sizeof(long int) * instance.n * instance.n + sizeof(long int *) * instance.n)) == NULL){
         fprintf(stderr,"Out of memory, exit.");
         exit(1);
@@ -216,86 +220,506 @@ long int** compute_distances(void)
 }
 
 
+static void candidate_keys( long int node, sort_pair_long *dv )
+/*    
+      FUNCTION: set up the (distance, city) pairs of city node for sorting
+      INPUT:    city node and array dv of n pairs
+      OUTPUT:   none
+      (SIDE)EFFECTS: dv[i] holds the distance from node to i; node itself and 
+                the pruned cities (if --reduce is used) get key LONG_MAX
+ */
+{
+    long int i;
+
+    for ( i = 0 ; i < instance.n ; i++ ) {  /* Copy distances from nodes to the others */
+        dv[i].key = instance.distance[node][i];
+        dv[i].index = i;
+    }
+    dv[node].key = LONG_MAX;  /* city is not nearest neighbour */
+    if ( reduce_flag ) {
+        /* pruned cities are placed at the end of the candidate lists */
+        for ( i = 0 ; i < instance.n ; i++ ) {
+            if ( instance.city_pruned[i] )
+                dv[i].key = LONG_MAX;
+        }
+    }
+}
+
+static long int quadrant_choose( long int node, long int quota, long int nn, 
+                                 const sort_pair_long *dv, char *chosen, long int *count, 
+                                 long int k )
+/*    
+      FUNCTION: choose quadrant candidates of city node until there are nn
+      INPUT:    city node, number of cities per quadrant, number nn of cities to 
+                choose, cities sorted by distance, marks of the chosen cities, 
+                cities chosen per quadrant and number k of cities chosen so far
+      OUTPUT:   number of chosen cities, nn unless there are too few cities
+      (SIDE)EFFECTS: chosen and count are updated
+      COMMENTS: first the quadrants are filled up to quota cities, the remaining 
+                places are taken by the nearest cities not yet chosen. The dummy 
+                city n-1 belongs to no quadrant
+ */
+{
+    long int i, c, q;
+    const long int dummy = instance.n - 1;
+
+    if ( node != dummy ) {
+        for ( i = 0 ; i < instance.n && k < nn ; i++ ) {
+            c = dv[i].index;
+            if ( dv[i].key == LONG_MAX ) 
+                break;
+            if ( c == dummy || chosen[c] ) 
+                continue;
+            q = ( instance.nodeptr[c].x >= instance.nodeptr[node].x ? 0 : 1 )
+                + ( instance.nodeptr[c].y >= instance.nodeptr[node].y ? 0 : 2 );
+            if ( count[q] < quota ) {
+                count[q]++;
+                chosen[c] = TRUE;
+                k++;
+            }
+        }
+    }
+    for ( i = 0 ; i < instance.n && k < nn ; i++ ) {
+        if ( !chosen[dv[i].index] ) {
+            chosen[dv[i].index] = TRUE;
+            k++;
+        }
+    }
+    return k;
+}
+
+static void quadrant_candidates( long int node, long int nn, long int prefix, 
+                                 sort_pair_long *dv, char *chosen, long int *list )
+/*    
+      FUNCTION: compute the quadrant candidate list of city node
+      INPUT:    city node, list length nn, number prefix of candidates used by 
+                the tour construction, work arrays dv (n pairs) and chosen 
+                (n chars, all FALSE) and the list to be filled
+      OUTPUT:   none
+      (SIDE)EFFECTS: list holds nn candidates; the first prefix and the others 
+                are each sorted by increasing distance
+      COMMENTS: the first prefix candidates take prefix/4 of the nearest cities 
+                of each of the four quadrants around node, the remaining ones 
+                extend this to nn/4 per quadrant. So the construction, which reads 
+                the first nn_ants candidates, sees all quadrants as well as the 
+                local search. On clustered instances this keeps arcs to the 
+                neighbouring clusters in the lists
+ */
+{
+    long int i, k, part, first, count[4];
+
+    candidate_keys(node, dv);
+    sort_pairs_long(dv, instance.n);
+
+    count[0] = count[1] = count[2] = count[3] = 0;
+    k = 0;
+    for ( part = 0 ; part < 2 ; part++ ) {
+        first = k;
+        k = quadrant_choose(node, ( part ? nn : prefix ) / 4, part ? nn : prefix, 
+                            dv, chosen, count, k);
+        /* dv is sorted by distance, so each part of the list is as well */
+        for ( i = 0 ; first < k ; i++ ) {
+            if ( chosen[dv[i].index] == TRUE ) {
+                chosen[dv[i].index] = 2;  /* listed */
+                list[first++] = dv[i].index;
+            }
+        }
+    }
+    for ( i = 0 ; i < nn ; i++ )
+        chosen[list[i]] = FALSE;
+}
+
+static void alpha_candidates( long int nn, long int prefix, long int **m_nnear )
+/*    
+      FUNCTION: compute the alpha-nearness candidate lists of all cities
+      INPUT:    list length nn, number prefix of candidates used by the tour 
+                construction and the lists to be filled
+      OUTPUT:   none
+      (SIDE)EFFECTS: m_nnear[i] holds the nn cities j with the smallest alpha(i,j); 
+                the prefix cities of smallest alpha come first, each part of the 
+                list is sorted by increasing distance
+      COMMENTS: alpha(i,j) is the increase of the length of the minimum 1-tree when 
+                arc (i,j) is forced into it, i.e., d(i,j) minus the longest arc on 
+                the path from i to j in the minimum spanning tree over the cities 
+                0 .. n-2 (Helsgaun, 2000). The dummy city n-1 is the special node 
+                of the 1-tree; its two arcs of length 0 are always in it, so for the 
+                dummy alpha is the plain distance. The spanning tree is computed 
+                with Prim's algorithm in O(n^2), the alpha values of one city in O(n)
+ */
+{
+    long int i, j, k, u, best;
+    const long int n = instance.n;
+    const long int dummy = n - 1;
+    long int *dad = malloc(n * sizeof(long int));
+    long int *order = malloc(n * sizeof(long int));
+    long int *key = malloc(n * sizeof(long int));
+    long int *beta = malloc(n * sizeof(long int));
+    long int *mark = malloc(n * sizeof(long int));
+    char *in_tree = calloc(n, sizeof(char));
+    sort_pair_long *dv = malloc(n * sizeof(sort_pair_long));
+
+    /* Prim's algorithm rooted at city 0; order[] is a topological order */
+    for ( j = 0 ; j < dummy ; j++ ) {
+        key[j] = instance.distance[0][j];
+        dad[j] = 0;
+    }
+    dad[0] = -1;
+    in_tree[0] = TRUE;
+    order[0] = 0;
+    for ( k = 1 ; k < dummy ; k++ ) {
+        best = -1;
+        for ( j = 0 ; j < dummy ; j++ ) {
+            if ( !in_tree[j] && ( best < 0 || key[j] < key[best] ) )
+                best = j;
+        }
+        in_tree[best] = TRUE;
+        order[k] = best;
+        for ( j = 0 ; j < dummy ; j++ ) {
+            if ( !in_tree[j] && instance.distance[best][j] < key[j] ) {
+                key[j] = instance.distance[best][j];
+                dad[j] = best;
+            }
+        }
+    }
+
+    for ( j = 0 ; j < n ; j++ )
+        mark[j] = -1;
+    for ( i = 0 ; i < n ; i++ ) {
+        candidate_keys(i, dv);
+        if ( i != dummy ) {
+            /* beta[j] is the longest arc on the tree path from i to j */
+            beta[i] = -1;
+            for ( u = i ; dad[u] >= 0 ; u = dad[u] ) {
+                beta[dad[u]] = MAX(beta[u], instance.distance[u][dad[u]]);
+                mark[dad[u]] = i;
+            }
+            for ( k = 0 ; k < dummy ; k++ ) {
+                j = order[k];
+                if ( j == i ) 
+                    continue;
+                if ( mark[j] != i )
+                    beta[j] = MAX(beta[dad[j]], instance.distance[j][dad[j]]);
+                if ( dv[j].key != LONG_MAX )
+                    dv[j].key -= beta[j];
+            }
+        }
+        sort_pairs_long(dv, n);
+        /* the chosen cities are ordered by distance, the prefix separately */
+        for ( k = 0 ; k < nn ; k++ ) {
+            j = dv[k].index;
+            dv[k].key = ( j == i || ( reduce_flag && instance.city_pruned[j] ) ) 
+                ? LONG_MAX : instance.distance[i][j];
+        }
+        sort_pairs_long(dv, prefix);
+        sort_pairs_long(dv + prefix, nn - prefix);
+        for ( k = 0 ; k < nn ; k++ )
+            m_nnear[i][k] = dv[k].index;
+    }
+
+    free(dad);
+    free(order);
+    free(key);
+    free(beta);
+    free(mark);
+    free(in_tree);
+    free(dv);
+}
+
+static const char *candidate_name[] = { "nearest", "quadrant", "alpha" };
+
+static unsigned long candidate_checksum( void )
+/*    
+      FUNCTION: fingerprint of the instance for the candidate cache
+      INPUT:    none
+      OUTPUT:   checksum of the edge weight type, the coordinates and, with 
+                --reduce, of the pruned cities
+ */
+{
+    unsigned long h;
+
+    h = word_checksum(0, instance.edge_weight_type, strlen(instance.edge_weight_type));
+    h = word_checksum(h, instance.nodeptr, (instance.n - 1) * sizeof(struct point));
+    if ( reduce_flag )
+        h = word_checksum(h, instance.city_pruned, instance.n);
+    return h;
+}
+
+static long int read_candidates( const char *file_name, long int nn, long int prefix, 
+                                 long int **m_nnear )
+/*    
+      FUNCTION: read cached candidate lists
+      INPUT:    name of the cache file, list length nn, length prefix of the part 
+                for the construction and the lists to be filled
+      OUTPUT:   TRUE if the cache matches the instance and the options
+ */
+{
+    FILE *f;
+    char name[LINE_BUF_LEN];
+    long int i, k, n, len, len_prefix, reduce, c;
+    unsigned long sum;
+
+    if ( (f = fopen(file_name, "r")) == NULL )
+        return FALSE;
+    if ( fscanf(f, "candidates %63s %ld %ld %ld %ld %lx", name, &n, &len, &len_prefix, &reduce, 
+                &sum) != 6 
+         || strcmp(name, candidate_name[candidate_flag]) != 0 || n != instance.n 
+         || len != nn || len_prefix != prefix || reduce != reduce_flag || sum != candidate_checksum() ) {
+        fclose(f);
+        return FALSE;
+    }
+    for ( i = 0 ; i < instance.n ; i++ ) {
+        for ( k = 0 ; k < nn ; k++ ) {
+            if ( fscanf(f, "%ld", &c) != 1 || c < 0 || c >= instance.n || c == i ) {
+                fclose(f);
+                return FALSE;
+            }
+            m_nnear[i][k] = c;
+        }
+    }
+    fclose(f);
+    return TRUE;
+}
+
+static void write_candidates( const char *file_name, long int nn, long int prefix, 
+                              long int **m_nnear )
+/*    
+      FUNCTION: cache candidate lists in a file
+      INPUT:    name of the cache file, list length nn, length prefix of the part 
+                for the construction and the lists
+      OUTPUT:   none
+      COMMENTS: nothing is written if the file cannot be created
+ */
+{
+    FILE *f;
+    long int i, k;
+
+    if ( (f = fopen(file_name, "w")) == NULL )
+        return;
+    fprintf(f, "candidates %s %ld %ld %ld %ld %lx\n", candidate_name[candidate_flag], 
+            instance.n, nn, prefix, reduce_flag, candidate_checksum());
+    for ( i = 0 ; i < instance.n ; i++ ) {
+        for ( k = 0 ; k < nn ; k++ ) 
+            fprintf(f, k ? " %ld" : "%ld", m_nnear[i][k]);
+        fputc('\n', f);
+    }
+    fclose(f);
+}
+
+long int candidate_list_length( void )
+/*    
+      FUNCTION: length of the candidate lists
+      INPUT:    none
+      OUTPUT:   the larger of --nnls and --nnants, at most n-1
+ */
+{
+    return MIN( MAX(nn_ls, nn_ants), instance.n - 1 );
+}
+
+long int candidate_prefix_length( void )
+/*    
+      FUNCTION: number of candidates read by the tour construction
+      INPUT:    none
+      OUTPUT:   --nnants, at most the length of the candidate lists
+ */
+{
+    return MIN( nn_ants, candidate_list_length() );
+}
+
 long int** compute_nn_lists( void )
 /*    
-      FUNCTION: computes nearest neighbor lists of depth nn for each city
+      FUNCTION: computes candidate lists of depth nn for each city
       INPUT:    none
-      OUTPUT:   pointer to the nearest neighbor lists
+      OUTPUT:   pointer to the candidate lists
+      COMMENTS: the kind of list is chosen by --candidates; a list is sorted by 
+                increasing distance, as the fixed radius search of 2-opt and 3-opt 
+                relies on it. Quadrant and alpha-nearness lists that are longer 
+                than --nnants are sorted in two parts, the first nn_ants entries 
+                and the others, so that the construction reads candidates of the 
+                chosen kind; instance.nn_split is then set to nn_ants and the 
+                fixed radius search continues with the second part. With --candcache, these lists are kept in that file 
+                and reused by later runs with the same instance, kind, list 
+                lengths and --reduce setting. A compiled instance provides the 
+                lists it was compiled with, see compiled_nn_lists
  */
 {
-    long int i, node, nn;
-    long int *distance_vector;
-    long int *help_vector;
+    long int node, nn, prefix, cached = FALSE;
+    sort_pair_long *distance_vector;
     long int **m_nnear;
+    char *chosen;
 
     TRACE ( printf("\n computing nearest neighbor lists, "); )
 
-    nn = MAX(nn_ls,nn_ants);
-    if ( nn >= instance.n )
-        nn = instance.n - 1;
+    nn = candidate_list_length();
+    prefix = candidate_prefix_length();
+    instance.nn_split = ( candidate_flag != CAND_NEAREST && prefix < nn ) ? prefix : 0;
     DEBUG ( assert( instance.n > nn ); )
 
     TRACE ( printf("nn = %ld ... \n",nn); )
 
+    if ( (m_nnear = compiled_nn_lists(nn, prefix)) != NULL ) {
+        if ( log_file ) {
+            fprintf(log_file, "Candidate lists: %s, %ld per city, read from compiled instance\n\n", 
+                    candidate_name[candidate_flag], nn);
+            fflush(log_file);
+        }
+        return m_nnear;
+    }
+
     if((m_nnear = malloc(sizeof(long int) * instance.n * nn + instance.n * sizeof(long int *))) == NULL){
         exit(EXIT_FAILURE);
     }
-    distance_vector = calloc(instance.n, sizeof(long int));
-    help_vector = calloc(instance.n, sizeof(long int));
-
-    for ( node = 0 ; node < instance.n ; node++ ) {  /* compute cnd-sets for all node */
+    for ( node = 0 ; node < instance.n ; node++ )
         m_nnear[node] = (long int *)(m_nnear + instance.n) + node * nn;
 
-        for ( i = 0 ; i < instance.n ; i++ ) {  /* Copy distances from nodes to the others */
-            distance_vector[i] = instance.distance[node][i];
-            help_vector[i] = i;
+    if ( candidate_flag != CAND_NEAREST && candidate_cache_name[0] != '\0' )
+        cached = read_candidates(candidate_cache_name, nn, prefix, m_nnear);
+    if ( !cached ) {
+        distance_vector = calloc(instance.n, sizeof(sort_pair_long));
+        chosen = calloc(instance.n, sizeof(char));
+        if ( candidate_flag == CAND_ALPHA ) {
+            alpha_candidates(nn, prefix, m_nnear);
         }
-        distance_vector[node] = LONG_MAX;  /* city is not nearest neighbour */
-        sort2(distance_vector, help_vector, 0, instance.n - 1);
-        for ( i = 0 ; i < nn ; i++ ) {
-            m_nnear[node][i] = help_vector[i];
+        else {
+            for ( node = 0 ; node < instance.n ; node++ ) {  /* compute cnd-sets for all node */
+                if ( candidate_flag == CAND_QUADRANT ) {
+                    quadrant_candidates(node, nn, prefix, distance_vector, chosen, m_nnear[node]);
+                }
+                else {
+                    long int i;
+
+                    candidate_keys(node, distance_vector);
+                    sort_pairs_long(distance_vector, instance.n);
+                    for ( i = 0 ; i < nn ; i++ ) {
+                        m_nnear[node][i] = distance_vector[i].index;
+                    }
+                }
+            }
         }
+        free(chosen);
+        free(distance_vector);
+        if ( candidate_flag != CAND_NEAREST && candidate_cache_name[0] != '\0' )
+            write_candidates(candidate_cache_name, nn, prefix, m_nnear);
+    }
+    if ( log_file && candidate_flag != CAND_NEAREST ) {
+        fprintf(log_file, "Candidate lists: %s, %ld per city, %s\n\n", candidate_name[candidate_flag], 
+                nn, cached ? "read from cache" : "computed");
+        fflush(log_file);
     }
-    free(distance_vector);
-    free(help_vector);
     TRACE ( printf("\n    .. done\n"); )
 
     return m_nnear;
 }
 
-long int compute_fitness( long int *t,  char *p ) 
+void prune_instance( void )
+/*    
+      FUNCTION: mark the cities and items that cannot be part of any feasible 
+                ThOP solution
+      INPUT:    none
+      OUTPUT:   none
+      (SIDE)EFFECTS: instance.city_pruned, instance.pruned_cities and 
+                instance.item_packable are allocated and set
+      COMMENTS: a city is pruned if going 0 -> city -> n-2 with an empty knapsack 
+                (i.e., at max_speed) already exceeds max_time; an item is pruned if 
+                it is heavier than the knapsack or if carrying only this item from its 
+                city to n-2 already exceeds max_time. The first 
+                city, the final city n-2 and the dummy city n-1 are never pruned
+ */
+{
+    long int i, j;
+    double   t;
+    const double v = ( instance.max_speed - instance.min_speed ) / instance.capacity_of_knapsack;
+
+    instance.city_pruned = calloc(instance.n, sizeof(char));
+    instance.pruned_cities = malloc(instance.n * sizeof(long int));
+    instance.item_packable = calloc(instance.m, sizeof(char));
+    instance.n_pruned = 0;
+    instance.m_packable = 0;
+
+    for ( i = 1 ; i < instance.n - 2 ; i++ ) {
+        t = (instance.distance[0][i] + instance.distance[i][instance.n - 2]) / instance.max_speed;
+        if ( t - EPSILON > instance.max_time ) {
+            instance.city_pruned[i] = TRUE;
+            instance.pruned_cities[instance.n_pruned++] = i;
+        }
+    }
+
+    for ( i = 0 ; i < instance.n ; i++ ) {
+        if ( instance.city_pruned[i] ) continue;
+        for ( j = instance.city_items[i] ; j < instance.city_items[i + 1] ; j++ ) {
+            if ( instance.item_weight[j] > instance.capacity_of_knapsack ) continue;
+            t = instance.distance[0][i] / instance.max_speed + 
+                instance.distance[i][instance.n - 2] / ( instance.max_speed - v * instance.item_weight[j] );
+            if ( t - EPSILON > instance.max_time ) continue;
+            instance.item_packable[j] = TRUE;
+            instance.m_packable++;
+        }
+    }
+
+    if (log_file) {
+        fprintf(log_file, "Pruned cities: %ld of %ld,        pruned items: %ld of %ld\n\n", instance.n_pruned, instance.n - 1, instance.m - instance.m_packable, instance.m);
+        fflush(log_file);
+    }
+}
+
+long int compute_fitness( long int *t,  unsigned long int *p, long int l ) 
+/*    
+      FUNCTION: compute the fitness of the ThOP solution generated from tour t
+      INPUT:    pointer to tour t, pointer to packing plan p (bitset over the items) 
+                and number l of tour positions that are considered
+      OUTPUT:   fitness of the ThOP solution generated from tour t
+      COMMENTS: only the cities t[1..l] followed by city n-2 are considered; for a 
+                complete tour l is n-3. Items of the cities at positions l+1 .. n-3 
+                (appended by complete_tour) are not packed
+ */
+{
+    return compute_fitness_rng( t, p, l, &seed );
+}
+
+long int compute_fitness_rng( long int *t,  unsigned long int *p, long int l, long int *idum ) 
 /*    
       FUNCTION: compute the fitness of the ThOP solution generated from tour t
-      INPUT:    pointer to tour t and pointer to packing plan p
+      INPUT:    as for compute_fitness, and the state idum of the random number 
+                generator that weights the packing heuristic
       OUTPUT:   fitness of the ThOP solution generated from tour t
+      COMMENTS: may be called concurrently if every caller passes its own idum; 
+                each of the max_packing_tries packing plans counts as one evaluation
  */
 {
     int i, j, k;
-    double par_a, par_b, par_c, par_sum;
-    long int prev_city, curr_city;
+    double par_a, par_b, par_c, par_sum, d_c;
+    long int prev_city, curr_city, c;
     double _total_time;
     long int _total_weight, total_weight, total_profit;    
+    long int m_tour;
     int violate_max_time;
     
     const double v = ( instance.max_speed - instance.min_speed ) / instance.capacity_of_knapsack;
     
-    long int *distance_accumulated = calloc (instance.n, sizeof(long int));
+    long int *distance_accumulated = malloc (instance.n * sizeof(long int));
 
     long int total_distance = 0;
 
-    for ( i = 0 ; i < instance.n ; i++ ) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+    n_evaluations += max_packing_tries;
+
+    for ( i = 0 ; i < l ; i++ ) {
         distance_accumulated[t[i]] = total_distance;
         total_distance += instance.distance[t[i]][t[i+1]];        
     }
+    distance_accumulated[t[l]] = total_distance;
+    total_distance += instance.distance[t[l]][instance.n - 2];
+    distance_accumulated[instance.n - 2] = total_distance;
     
-    double *item_vector = malloc(instance.m * sizeof(double));
-    long int *help_vector = malloc(instance.m * sizeof(long int));
+    /* only items that may be part of a feasible packing plan are considered */
+    sort_pair_double *item_vector = malloc(instance.m_packable * sizeof(sort_pair_double));
     
     long int *profit_accumulated = malloc(instance.n * sizeof(long int));
     long int *weight_accumulated = malloc(instance.n * sizeof(long int));
     
     long int best_packing_plan_profit = 0;
-    char *tmp_packing_plan = malloc(instance.m * sizeof(char));
+    unsigned long int *tmp_packing_plan = generate_bitset(instance.m);
     
     long int _try;
         
@@ -305,43 +729,52 @@ long int compute_fitness( long int *t,  char *p )
             profit_accumulated[i] = weight_accumulated[i] = 0;
         }
         
-        par_a = ran01( &seed );  /* uniform random number between [0.0, 1.0] */
-        par_b = ran01( &seed );  /* uniform random number between [0.0, 1.0] */
-        par_c = ran01( &seed );  /* uniform random number between [0.0, 1.0] */
+        par_a = ran01( idum );  /* uniform random number between [0.0, 1.0] */
+        par_b = ran01( idum );  /* uniform random number between [0.0, 1.0] */
+        par_c = ran01( idum );  /* uniform random number between [0.0, 1.0] */
 
         par_sum = (par_a + par_b + par_c); 
         par_a /= par_sum; par_b /= par_sum; par_c /= par_sum;
                 
-        for ( j = 0 ; j < instance.m ; j++ ) {
-            item_vector[j] = ( 
-                                -1.0 * pow(instance.itemptr[j].profit, par_a)
-                            ) 
-                            / 
-                            ( 
-                                pow(instance.itemptr[j].weight, par_b) * pow((distance_accumulated[instance.n - 2] - distance_accumulated[instance.itemptr[j].id_city]), par_c)
-                            );
-            help_vector[j] = j;
+        /* score the items city by city in tour order; the items of a city are 
+           contiguous and the distance term is computed once per city */
+        m_tour = 0;
+        for ( i = 0 ; i <= l + 1 ; i++ ) {
+            c = ( i <= l ) ? t[i] : instance.n - 2;
+            if ( instance.city_items[c] == instance.city_items[c + 1] ) continue;
+            d_c = pow((distance_accumulated[instance.n - 2] - distance_accumulated[c]), par_c);
+            for ( j = instance.city_items[c] ; j < instance.city_items[c + 1] ; j++ ) {
+                if ( !instance.item_packable[j] ) continue;
+                item_vector[m_tour].key = ( 
+                                    -1.0 * pow(instance.item_profit[j], par_a)
+                                ) 
+                                / 
+                                ( 
+                                    pow(instance.item_weight[j], par_b) * d_c
+                                );
+                item_vector[m_tour++].index = j;
+            }
         }
 
-        sort2_double(item_vector, help_vector, 0, instance.m - 1);
+        sort_pairs_double(item_vector, m_tour);
     
         total_weight = 0, total_profit = 0;            
+        clear_bitset(tmp_packing_plan, instance.m);
         
-        for ( k = 0 ; k < instance.m ; k++ ) {
+        for ( k = 0 ; k < m_tour ; k++ ) {
 
-            j = help_vector[k];
-            tmp_packing_plan[j] = 0;
+            j = item_vector[k].index;
             
-            if ( total_weight + instance.itemptr[j].weight > instance.capacity_of_knapsack ) continue;
+            if ( total_weight + instance.item_weight[j] > instance.capacity_of_knapsack ) continue;
 
-            profit_accumulated[instance.itemptr[j].id_city] += instance.itemptr[j].profit;
-            weight_accumulated[instance.itemptr[j].id_city] += instance.itemptr[j].weight; 
+            profit_accumulated[instance.item_city[j]] += instance.item_profit[j];
+            weight_accumulated[instance.item_city[j]] += instance.item_weight[j]; 
             
             violate_max_time = FALSE;
             _total_time = _total_weight = 0;
             prev_city = 0;
-            for ( i = 1 ; i < instance.n - 1; i++ ) {
-                curr_city = t[i];
+            for ( i = 1 ; i <= l + 1 ; i++ ) {
+                curr_city = ( i <= l ) ? t[i] : instance.n - 2;
                 if ( weight_accumulated[curr_city] == 0 && curr_city != instance.n - 2) continue;
                 _total_time += instance.distance[prev_city][curr_city] / ( instance.max_speed - v * _total_weight );    
                 if ( _total_time - EPSILON > instance.max_time ) {
@@ -352,30 +785,65 @@ long int compute_fitness( long int *t,  char *p )
             }
 
             if ( violate_max_time == FALSE) {
-                total_profit += instance.itemptr[j].profit;     
-                total_weight += instance.itemptr[j].weight;
-                tmp_packing_plan[j] = 1;
+                total_profit += instance.item_profit[j];     
+                total_weight += instance.item_weight[j];
+                BITSET_SET(tmp_packing_plan, j);
             }
             else {
-                profit_accumulated[instance.itemptr[j].id_city] -= instance.itemptr[j].profit;
-                weight_accumulated[instance.itemptr[j].id_city] -= instance.itemptr[j].weight; 
+                profit_accumulated[instance.item_city[j]] -= instance.item_profit[j];
+                weight_accumulated[instance.item_city[j]] -= instance.item_weight[j]; 
             }
         }
         
         if ( total_profit > best_packing_plan_profit) {
             best_packing_plan_profit = total_profit;
-            for ( j = 0 ; j < instance.m ; j++ ) {
-                p[j] = tmp_packing_plan[j];
-            }            
+            copy_bitset(tmp_packing_plan, p, instance.m);
         }
     }
     
     free(distance_accumulated);
     free(item_vector);
-    free(help_vector);
     free(profit_accumulated);
     free(weight_accumulated);
     free(tmp_packing_plan);
                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                         
     return instance.UB + 1 - best_packing_plan_profit;
 }
+
+long int packing_plan_profit( unsigned long int *p ) 
+/*    
+      FUNCTION: compute the total profit of the items picked in packing plan p
+      INPUT:    pointer to packing plan p
+      OUTPUT:   sum of the profits of the picked items
+      COMMENTS: the bitset is scanned word by word, empty words are skipped
+ */
+{
+    long int i, profit = 0;
+    unsigned long int w;
+
+    for ( i = 0 ; i < (long int) BITSET_WORDS(instance.m) ; i++ ) {
+        for ( w = p[i] ; w ; w &= w - 1 ) {
+            profit += instance.item_profit[i * BITS_PER_WORD + lowest_bit(w)];
+        }
+    }
+    return profit;
+}
+
+long int packing_plan_weight( unsigned long int *p ) 
+/*    
+      FUNCTION: compute the total weight of the items picked in packing plan p
+      INPUT:    pointer to packing plan p
+      OUTPUT:   sum of the weights of the picked items
+      COMMENTS: the bitset is scanned word by word, empty words are skipped
+ */
+{
+    long int i, weight = 0;
+    unsigned long int w;
+
+    for ( i = 0 ; i < (long int) BITSET_WORDS(instance.m) ; i++ ) {
+        for ( w = p[i] ; w ; w &= w - 1 ) {
+            weight += instance.item_weight[i * BITS_PER_WORD + lowest_bit(w)];
+        }
+    }
+    return weight;
+}
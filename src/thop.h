@@ -61,12 +61,6 @@ struct point {
     double y;
 };
 
-struct item { 
-    long int profit;
-    long int weight;
-    long int id_city;
-};
-
 struct problem {
     char          knapsack_data_type[LINE_BUF_LEN];              /* knapsack data type */
     char          edge_weight_type[LINE_BUF_LEN];                /* selfexplanatory */
@@ -79,15 +73,25 @@ struct problem {
     double        max_speed;              /* maximum speed of the thief */
     long int      n_near;                 /* number of nearest neighbors */
     struct point  *nodeptr;               /* array of structs containing coordinates of nodes */
-    struct item   *itemptr;               /* array of structs containing item data */
+    long int      *item_profit;           /* profit of each item; items are grouped by city (CSR layout) */
+    long int      *item_weight;           /* weight of each item */
+    long int      *item_city;             /* city each item is assigned to */
+    long int      *item_id;               /* index of each item in the instance file */
+    long int      *city_items;            /* items of city i are city_items[i] .. city_items[i+1]-1 */
     long int      **distance;             /* distance matrix: distance[i][j] gives distance between city i und j */
     long int      **nn_list;              /* nearest neighbor list; contains for each node i a sorted list of n_near nearest neighbors */
+    long int      nn_split;               /* nn_list[i][nn_split..] is sorted separately, 0 if the lists are sorted as a whole */
     long int      UB;                     /* objective value of the optimal solution of the fractional knapsack problem */
+    char          *city_pruned;           /* city_pruned[i] is TRUE if city i cannot be visited within max_time */
+    long int      *pruned_cities;         /* list of the pruned cities */
+    long int      n_pruned;               /* number of pruned cities */
+    char          *item_packable;         /* item_packable[j] is TRUE if item j may be part of a feasible packing plan */
+    long int      m_packable;             /* number of packable items */
 };
 
 extern struct problem instance;
 
-long int (*distance)(long int, long int);  /* pointer to function returning distance */
+extern long int (*distance)(long int, long int);  /* pointer to function returning distance */
 
 long int round_distance(long int i, long int j);
 
@@ -99,6 +103,18 @@ long int att_distance(long int i, long int j);
 
 long int** compute_distances(void);
 
+long int candidate_list_length(void);
+
+long int candidate_prefix_length(void);
+
 long int** compute_nn_lists(void);
 
-long int compute_fitness(long int *t, char *p);
\ No newline at end of file
+void prune_instance(void);
+
+long int compute_fitness(long int *t, unsigned long int *p, long int l);
+
+long int compute_fitness_rng(long int *t, unsigned long int *p, long int l, long int *idum);
+
+long int packing_plan_profit(unsigned long int *p);
+
+long int packing_plan_weight(unsigned long int *p);
\ No newline at end of file
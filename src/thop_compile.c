@@ -0,0 +1,68 @@
+/*
+
+       AAAA    CCCC   OOOO   TTTTTT   SSSSS  PPPPP
+      AA  AA  CC     OO  OO    TT    SS      PP  PP
+      AAAAAA  CC     OO  OO    TT     SSSS   PPPPP
+      AA  AA  CC     OO  OO    TT        SS  PP
+      AA  AA   CCCC   OOOO     TT    SSSSS   PP
+
+######################################################
+##########    ACO algorithms for the TSP    ##########
+######################################################
+
+      Version: 1.0
+      File:    thop_compile.c
+      Purpose: thop-compile, converts a ThOP instance into the binary format
+               that acothop loads without parsing and computing
+      Check:   README and gpl.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "inout.h"
+#include "thop.h"
+#include "timer.h"
+
+int main(int argc, char *argv[])
+/*
+      FUNCTION:       read an instance, compute distances, candidate lists and the
+                      bound UB and write them to a compiled instance file
+      INPUT:          instance file, compiled file and options of acothop
+      OUTPUT:         0 if the file was written
+      COMMENTS:       the options --candidates, --nnants, --nnls and --reduce choose
+                      the candidate lists that are stored; acothop -i <compiled file>
+                      uses them if it runs with the same settings (or, for nearest
+                      neighbour lists, shorter ones) and computes the lists otherwise
+ */
+{
+    char **args;
+    long int i;
+
+    if ( argc < 3 ) {
+        fprintf(stderr, "Usage: %s <instance.thop> <compiled file> [acothop options]\n", argv[0]);
+        exit(1);
+    }
+    /* -i and -o are set from the file names; one ant suffices to set up the instance */
+    if ( (args = malloc((argc + 4) * sizeof(char *))) == NULL )
+        exit(EXIT_FAILURE);
+    args[0] = argv[0];
+    args[1] = "-i";
+    args[2] = argv[1];
+    args[3] = "-o";
+    args[4] = argv[2];
+    args[5] = "--ants";
+    args[6] = "1";
+    for ( i = 3 ; i < argc ; i++ )
+        args[i + 4] = argv[i];
+
+    start_timers();
+    init_program(argc + 4, args);
+    instance.nn_list = compute_nn_lists();
+    write_compiled_instance(argv[2]);
+    printf("%s: %ld cities, %ld items, %ld candidates per city\n", argv[2],
+           instance.n - 1, instance.m, candidate_list_length());
+
+    free(args);
+    return 0;
+}
@@ -50,7 +50,12 @@
 
  ***************************************************************************/
 
-typedef enum type_timer {REAL, VIRTUAL} TIMER_TYPE;
+typedef enum type_timer {REAL, VIRTUAL, THREAD} TIMER_TYPE;
+
+extern TIMER_TYPE budget_timer;  /* clock that measures the time limit and the reported times */
 
 void start_timers(void);
-double elapsed_time(TIMER_TYPE type);
\ No newline at end of file
+double elapsed_time(TIMER_TYPE type);
+void resume_timers(double seconds);
+void set_deadline(double seconds);
+int deadline_reached(void);
@@ -17,46 +17,116 @@
       Check:   README.txt and legal.txt
  */
 
+#define _POSIX_C_SOURCE 199309L
+
 #include <stdio.h>
-#include <sys/time.h>
-#include <sys/resource.h>
+#include <time.h>
 
 #include "timer.h"
 
-static struct rusage res;
-static struct timeval tp;
-static double virtual_time, real_time;
+TIMER_TYPE budget_timer = VIRTUAL;
+
+/* wall-clock, process CPU and thread CPU time, indexed by TIMER_TYPE */
+static const clockid_t clock_id[3] = { CLOCK_MONOTONIC, CLOCK_PROCESS_CPUTIME_ID, CLOCK_THREAD_CPUTIME_ID };
+static struct timespec start_time[3];
+static struct timespec deadline;
 
 void start_timers(void)
 /*    
-      FUNCTION:       virtual and real time of day are computed and stored to 
+      FUNCTION:       real, virtual and thread time are computed and stored to 
                       allow at later time the computation of the elapsed time 
-                      (virtual or real) 
       INPUT:          none
       OUTPUT:         none
-      (SIDE)EFFECTS:  virtual and real time are computed   
+      (SIDE)EFFECTS:  the start times of all clocks are stored; the deadline is 
+                      set to the start time
+      COMMENTS:       the THREAD clock is the CPU time of the calling thread, so 
+                      it may only be read by the thread that started the timers
  */
 {
-    getrusage( RUSAGE_SELF, &res );
-    virtual_time = (double) res.ru_utime.tv_sec + (double) res.ru_stime.tv_sec + (double) res.ru_utime.tv_usec / 1000000.0 + (double) res.ru_stime.tv_usec / 1000000.0;
-    gettimeofday( &tp, NULL );
-    real_time = (double) tp.tv_sec + (double) tp.tv_usec / 1000000.0;
+    int i;
+
+    for ( i = REAL ; i <= THREAD ; i++ )
+        clock_gettime( clock_id[i], &start_time[i] );
+    deadline = start_time[budget_timer];
 }
 
 double elapsed_time(TIMER_TYPE type)
 /*    
       FUNCTION:       return the time used in seconds (virtual or real, depending on type) 
-      INPUT:          TIMER_TYPE (virtual or real time)
-      OUTPUT:         seconds since last call to start_timers (virtual or real)
+      INPUT:          TIMER_TYPE (real, virtual or thread time)
+      OUTPUT:         seconds since last call to start_timers
       (SIDE)EFFECTS:  none
  */
 {
-    if (type == REAL) {
-        gettimeofday( &tp, NULL );
-        return ( (double) tp.tv_sec + (double) tp.tv_usec / 1000000.0 - real_time );
+    struct timespec now;
+
+    clock_gettime( clock_id[type], &now );
+    return (double) ( now.tv_sec - start_time[type].tv_sec ) 
+        + (double) ( now.tv_nsec - start_time[type].tv_nsec ) / 1000000000.0;
+}
+
+void resume_timers(double seconds)
+/*    
+      FUNCTION:       continue timing a run that was interrupted after the given 
+                      time, e.g., when it is resumed from a checkpoint
+      INPUT:          seconds already used
+      OUTPUT:         none
+      (SIDE)EFFECTS:  the start times of all clocks are moved such that 
+                      elapsed_time returns seconds now; set_deadline has to be 
+                      called again
+ */
+{
+    int i;
+    long int nsec;
+    struct timespec now;
+
+    for ( i = REAL ; i <= THREAD ; i++ ) {
+        clock_gettime( clock_id[i], &now );
+        start_time[i].tv_sec = now.tv_sec - (time_t) seconds;
+        nsec = now.tv_nsec - (long int) ( ( seconds - (double) (time_t) seconds ) * 1000000000.0 );
+        if ( nsec < 0 ) {
+            start_time[i].tv_sec--;
+            nsec += 1000000000L;
+        }
+        start_time[i].tv_nsec = nsec;
     }
-    else {
-        getrusage( RUSAGE_SELF, &res );
-        return ( (double) res.ru_utime.tv_sec + (double) res.ru_stime.tv_sec + (double) res.ru_utime.tv_usec / 1000000.0 + (double) res.ru_stime.tv_usec / 1000000.0 - virtual_time );
+}
+
+void set_deadline(double seconds)
+/*    
+      FUNCTION:       set the deadline to the given number of seconds of budget_timer 
+                      after the last call to start_timers
+      INPUT:          length of the time budget in seconds
+      OUTPUT:         none
+      (SIDE)EFFECTS:  deadline is set; a budget <= 0 means that it is reached at once
+ */
+{
+    long int nsec;
+
+    deadline = start_time[budget_timer];
+    if ( seconds <= 0. )
+        return;
+    deadline.tv_sec += (time_t) seconds;
+    nsec = deadline.tv_nsec + (long int) ( ( seconds - (double) (time_t) seconds ) * 1000000000.0 );
+    if ( nsec >= 1000000000L ) {
+        deadline.tv_sec++;
+        nsec -= 1000000000L;
     }
-}
\ No newline at end of file
+    deadline.tv_nsec = nsec;
+}
+
+int deadline_reached(void)
+/*    
+      FUNCTION:       check whether the deadline has been reached
+      INPUT:          none
+      OUTPUT:         1 if the clock of budget_timer has reached the deadline, 0 otherwise
+      COMMENTS:       one clock_gettime call and an integer comparison; 
+                      CLOCK_MONOTONIC is read without a system call
+ */
+{
+    struct timespec now;
+
+    clock_gettime( clock_id[budget_timer], &now );
+    return now.tv_sec > deadline.tv_sec || 
+        ( now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec );
+}
@@ -54,6 +54,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include <assert.h>
 
 #include "inout.h"
 #include "utilities.h"
@@ -274,87 +275,155 @@ void sort_double(double *v, long int left, long int right)
     sort_double(v, last+1, right);
 }
 
-void swap2(long int *v, long int *v2, long int i, long int j)
+/* Pairs are ordered by key, ties are broken by index. All elements are
+   therefore distinct, equal keys do not degrade the partitioning, and the 
+   result does not depend on the initial order of the pairs. */
+#define PAIR_LESS(a,b)   ((a).key < (b).key || ((a).key == (b).key && (a).index < (b).index))
+
+#define SORT_STACK_SIZE  64   /* > log2 of any array size */
+#define SORT_SMALL       16   /* ranges up to this length are left to insertion sort */
+
+static long int sort_depth_limit( long int n )
 /*    
-      FUNCTION:       auxiliary routine for sorting an integer array  
-      INPUT:          two arraya, two indices
-      OUTPUT:         none
-      (SIDE)EFFECTS:  elements at position i and j of the two arrays are swapped
+      FUNCTION:       depth limit of introsort's partitioning phase
+      INPUT:          number of elements
+      OUTPUT:         2 * floor(log2(n))
  */
 {
-    long int tmp;
+    long int d = 0;
 
-    tmp = v[i];
-    v[i] = v[j];
-    v[j] = tmp;
-    tmp = v2[i];
-    v2[i] = v2[j];
-    v2[j] = tmp;
+    while ( n > 1 ) {
+        n >>= 1;
+        d += 2;
+    }
+    return d;
 }
 
-void swap2_double(double *v, double *v2, long int i, long int j)
-/*    
-      FUNCTION:       auxiliary routine for sorting an double array  
-      INPUT:          two arraya, two indices
-      OUTPUT:         none
-      (SIDE)EFFECTS:  elements at position i and j of the two arrays are swapped
- */
-{
-    double tmp;
+/* The functions for long int and double keys share these bodies; they sort 
+   an array p of n pairs of type pair_type. */
+
+#define HEAP_SORT_PAIRS_BODY(pair_type) \
+{                                                                        \
+    long int i, parent, child, end;                                      \
+    pair_type tmp;                                                       \
+                                                                         \
+    for ( i = n / 2 - 1, end = n ; end > 1 ; ) {                         \
+        if ( i >= 0 ) {            /* build heap */                      \
+            tmp = p[i];                                                  \
+            parent = i--;                                                \
+        }                                                                \
+        else {                     /* move maximum to the end */         \
+            tmp = p[--end];                                              \
+            p[end] = p[0];                                               \
+            parent = 0;                                                  \
+        }                                                                \
+        while ( (child = 2 * parent + 1) < end ) {                       \
+            if ( child + 1 < end && PAIR_LESS(p[child], p[child + 1]) )  \
+                child++;                                                 \
+            if ( !PAIR_LESS(tmp, p[child]) )                             \
+                break;                                                   \
+            p[parent] = p[child];                                        \
+            parent = child;                                              \
+        }                                                                \
+        p[parent] = tmp;                                                 \
+    }                                                                    \
+}
 
-    tmp = v[i];
-    v[i] = v[j];
-    v[j] = tmp;
-    tmp = v2[i];
-    v2[i] = v2[j];
-    v2[j] = tmp;
+#define SORT_PAIRS_BODY(pair_type, heap_sort) \
+{                                                                                                 \
+    long int lo_stack[SORT_STACK_SIZE], hi_stack[SORT_STACK_SIZE], depth_stack[SORT_STACK_SIZE];  \
+    long int top = 0, lo, hi, depth, mid, i, j;                                                   \
+    pair_type pivot, tmp;                                                                         \
+                                                                                                  \
+    lo_stack[0] = 0; hi_stack[0] = n; depth_stack[0] = sort_depth_limit(n); top = 1;              \
+    while ( top > 0 ) {                                                                           \
+        top--;                                                                                    \
+        lo = lo_stack[top]; hi = hi_stack[top]; depth = depth_stack[top];                         \
+        while ( hi - lo > SORT_SMALL ) {                                                          \
+            if ( depth-- == 0 ) {                                                                 \
+                heap_sort(p + lo, hi - lo);                                                       \
+                break;                                                                            \
+            }                                                                                     \
+            /* median of three to p[lo] */                                                        \
+            mid = lo + (hi - lo) / 2;                                                             \
+            if ( PAIR_LESS(p[mid], p[lo]) ) { tmp = p[mid]; p[mid] = p[lo]; p[lo] = tmp; }        \
+            if ( PAIR_LESS(p[hi - 1], p[mid]) ) {                                                 \
+                tmp = p[mid]; p[mid] = p[hi - 1]; p[hi - 1] = tmp;                                \
+                if ( PAIR_LESS(p[mid], p[lo]) ) { tmp = p[mid]; p[mid] = p[lo]; p[lo] = tmp; }    \
+            }                                                                                     \
+            tmp = p[mid]; p[mid] = p[lo]; p[lo] = tmp;                                            \
+            pivot = p[lo];                                                                        \
+            /* Hoare partition: p[lo..j] <= pivot <= p[j+1..hi-1] */                              \
+            i = lo - 1; j = hi;                                                                   \
+            for ( ; ; ) {                                                                         \
+                do i++; while ( PAIR_LESS(p[i], pivot) );                                         \
+                do j--; while ( PAIR_LESS(pivot, p[j]) );                                         \
+                if ( i >= j ) break;                                                              \
+                tmp = p[i]; p[i] = p[j]; p[j] = tmp;                                              \
+            }                                                                                     \
+            /* defer the larger part, continue with the smaller one */                            \
+            assert(top < SORT_STACK_SIZE);                                                        \
+            if ( j + 1 - lo > hi - (j + 1) ) {                                                    \
+                lo_stack[top] = lo; hi_stack[top] = j + 1; depth_stack[top++] = depth;            \
+                lo = j + 1;                                                                       \
+            }                                                                                     \
+            else {                                                                                \
+                lo_stack[top] = j + 1; hi_stack[top] = hi; depth_stack[top++] = depth;            \
+                hi = j + 1;                                                                       \
+            }                                                                                     \
+        }                                                                                         \
+    }                                                                                             \
+    for ( i = 1 ; i < n ; i++ ) {                                                                 \
+        tmp = p[i];                                                                               \
+        for ( j = i ; j > 0 && PAIR_LESS(tmp, p[j - 1]) ; j-- )                                   \
+            p[j] = p[j - 1];                                                                      \
+        p[j] = tmp;                                                                               \
+    }                                                                                             \
 }
 
-void sort2(long int *v, long int *v2, long int left, long int right)
+static void heap_sort_pairs_long( sort_pair_long *p, long int n )
 /*    
-      FUNCTION:       recursive routine (quicksort) for sorting one array; second 
-                      arrays does the same sequence of swaps  
-      INPUT:          two arrays, two indices
+      FUNCTION:       heapsort, fallback of sort_pairs_long for degenerated ranges
+      INPUT:          pointer to the first pair, number of pairs
       OUTPUT:         none
-      (SIDE)EFFECTS:  elements at position i and j of the two arrays are swapped
+      (SIDE)EFFECTS:  p[0..n-1] is sorted
  */
-{
-    long int k, last;
+HEAP_SORT_PAIRS_BODY(sort_pair_long)
 
-    if (left >= right)
-        return;
-    swap2(v, v2, left, (left + right)/2);
-    last = left;
-    for (k=left+1; k <= right; k++)
-        if (v[k] < v[left])
-            swap2(v, v2, ++last, k);
-    swap2(v, v2, left, last);
-    sort2(v, v2, left, last);
-    sort2(v, v2, last+1, right);
-}
+void sort_pairs_long( sort_pair_long *p, long int n )
+/*    
+      FUNCTION:       sort an array of (key, index) pairs by increasing key 
+      INPUT:          array of pairs, number of pairs
+      OUTPUT:         none
+      (SIDE)EFFECTS:  p is sorted, ties are broken by increasing index
+      COMMENTS:       non-recursive introsort: quicksort with median-of-three 
+                      pivot on an explicit stack, heapsort once the depth limit 
+                      is exceeded and a final insertion sort pass; O(n log n) 
+                      in the worst case
+ */
+SORT_PAIRS_BODY(sort_pair_long, heap_sort_pairs_long)
 
-void sort2_double(double *v, double *v2, long int left, long int right)
+static void heap_sort_pairs_double( sort_pair_double *p, long int n )
 /*    
-      FUNCTION:       recursive routine (quicksort) for sorting one double array; second 
-                      arrays does the same sequence of swaps  
-      INPUT:          two arrays, two indices
+      FUNCTION:       heapsort, fallback of sort_pairs_double for degenerated ranges
+      INPUT:          pointer to the first pair, number of pairs
       OUTPUT:         none
-      (SIDE)EFFECTS:  elements at position i and j of the two arrays are swapped
+      (SIDE)EFFECTS:  p[0..n-1] is sorted
  */
-{
-    long int k, last;
+HEAP_SORT_PAIRS_BODY(sort_pair_double)
 
-    if (left >= right)
-        return;
-    swap2_double(v, v2, left, (left + right)/2);
-    last = left;
-    for (k=left+1; k <= right; k++)
-        if (v[k] < v[left])
-            swap2_double(v, v2, ++last, k);
-    swap2_double(v, v2, left, last);
-    sort2_double(v, v2, left, last);
-    sort2_double(v, v2, last+1, right);
-}
+void sort_pairs_double( sort_pair_double *p, long int n )
+/*    
+      FUNCTION:       sort an array of (key, index) pairs by increasing key 
+      INPUT:          array of pairs, number of pairs
+      OUTPUT:         none
+      (SIDE)EFFECTS:  p is sorted, ties are broken by increasing index
+      COMMENTS:       non-recursive introsort: quicksort with median-of-three 
+                      pivot on an explicit stack, heapsort once the depth limit 
+                      is exceeded and a final insertion sort pass; O(n log n) 
+                      in the worst case
+ */
+SORT_PAIRS_BODY(sort_pair_double, heap_sort_pairs_double)
 
 double ran01( long *idum )
 /*    
@@ -435,3 +504,71 @@ double ** generate_double_matrix( long int n, long int m)
     }
     return matrix;
 }
+
+unsigned long int * generate_bitset( long int n )
+/*    
+      FUNCTION:       malloc a bitset for n elements with all bits cleared
+      INPUT:          number of elements
+      OUTPUT:         pointer to bitset
+      (SIDE)EFFECTS:  
+ */
+{
+    unsigned long int *b;
+
+    if((b = calloc(BITSET_WORDS(n), sizeof(unsigned long int))) == NULL){
+        printf("Out of memory, exit.");
+        exit(1);
+    }
+    return b;
+}
+
+void clear_bitset( unsigned long int *b, long int n )
+/*    
+      FUNCTION:       clear all bits of a bitset of n elements
+      INPUT:          pointer to bitset, number of elements
+      OUTPUT:         none
+      (SIDE)EFFECTS:  all bits of b are zero
+ */
+{
+    long int i;
+
+    for ( i = 0 ; i < (long int) BITSET_WORDS(n) ; i++ ) {
+        b[i] = 0UL;
+    }
+}
+
+void copy_bitset( unsigned long int *from, unsigned long int *to, long int n )
+/*    
+      FUNCTION:       copy a bitset of n elements word by word
+      INPUT:          pointers to source and destination bitset, number of elements
+      OUTPUT:         none
+      (SIDE)EFFECTS:  to is a copy of from
+ */
+{
+    long int i;
+
+    for ( i = 0 ; i < (long int) BITSET_WORDS(n) ; i++ ) {
+        to[i] = from[i];
+    }
+}
+
+long int lowest_bit( unsigned long int w )
+/*    
+      FUNCTION:       index of the lowest set bit of a (nonzero) word
+      INPUT:          word
+      OUTPUT:         index of the lowest set bit
+      (SIDE)EFFECTS:  none
+ */
+{
+#if defined(__GNUC__)
+    return __builtin_ctzl( w );
+#else
+    long int k = 0;
+
+    while ( !(w & 1UL) ) {
+        w >>= 1;
+        k++;
+    }
+    return k;
+#endif
+}
@@ -62,6 +62,26 @@
 #define MAX(x,y)        ((x)>=(y)?(x):(y))
 #define MIN(x,y)        ((x)<=(y)?(x):(y))
 
+/* macros for bitsets stored as arrays of unsigned long int words, e.g. packing plans */
+
+#define BITS_PER_WORD           (8 * sizeof(unsigned long int))
+#define BITSET_WORDS(n)         (((n) + BITS_PER_WORD - 1) / BITS_PER_WORD)
+#define BITSET_TEST(b,i)        (((b)[(i) / BITS_PER_WORD] >> ((i) % BITS_PER_WORD)) & 1UL)
+#define BITSET_SET(b,i)         ((b)[(i) / BITS_PER_WORD] |= 1UL << ((i) % BITS_PER_WORD))
+#define BITSET_RESET(b,i)       ((b)[(i) / BITS_PER_WORD] &= ~(1UL << ((i) % BITS_PER_WORD)))
+
+/* (key, index) pairs for sort_pairs_long and sort_pairs_double */
+
+typedef struct {
+    long int key;
+    long int index;
+} sort_pair_long;
+
+typedef struct {
+    double   key;
+    long int index;
+} sort_pair_double;
+
 #define DEBUG( x )
 
 #define TRACE( x )
@@ -99,13 +119,9 @@ void sort_double ( double *v, long int left, long int right );
 
 double quantil ( long int *v, double q, long int numbers );
 
-void swap2(long int *v, long int *v2, long int i, long int j);
-
-void swap2_double(double *v, double *v2, long int i, long int j);
+void sort_pairs_long ( sort_pair_long *p, long int n );
 
-void sort2(long int *v, long int *v2, long int left, long int right);
-
-void sort2_double(double *v, double *v2, long int left, long int right);
+void sort_pairs_double ( sort_pair_double *p, long int n );
 
 double ran01 ( long *idum );
 
@@ -113,4 +129,12 @@ long int random_number ( long *idum );
 
 long int** generate_int_matrix( long int n, long int m);
 
-double** generate_double_matrix( long int n, long int m);
\ No newline at end of file
+double** generate_double_matrix( long int n, long int m);
+
+unsigned long int* generate_bitset( long int n );
+
+void clear_bitset( unsigned long int *b, long int n );
+
+void copy_bitset( unsigned long int *from, unsigned long int *to, long int n );
+
+long int lowest_bit( unsigned long int w );
\ No newline at end of file